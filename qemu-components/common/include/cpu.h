@@ -19,6 +19,8 @@
 #include <cci_configuration>
 
 #include <libgssync.h>
+#include <thread_placement.h>
+#include <trace_exporter.h>
 
 #include "device.h"
 #include "ports/initiator.h"
@@ -57,11 +59,47 @@ protected:
     std::shared_ptr<gs::tlm_quantumkeeper_extended> m_qk;
     bool m_finished = false;
     bool m_started = false;
+    bool m_placed = false; // set from the vCPU thread, once placed and profiled
     std::mutex m_can_delete;
     QemuCpuHintTlmExtension m_cpu_hint_ext;
 
     uint64_t m_quantum_ns; // For convenience
 
+    std::vector<std::unique_ptr<cci::cci_param<uint64_t>>> m_profile_params;
+
+    /* Start of the current CPU loop run, for the timeline. vCPU thread only. */
+    gs::TraceExporter::clock::time_point m_loop_start;
+    uint64_t m_loop_sc_ns = 0;
+
+    /*
+     * Publish the time breakdown of the vCPU thread as parameters, every
+     * p_profile_interval_us of simulated time.
+     */
+    void publish_profile()
+    {
+        for (;;) {
+            wait(sc_core::sc_time(p_profile_interval_us, sc_core::SC_US));
+            gs::sync_profile& prof = m_qk->get_profile();
+            for (int s = 0; s < gs::sync_profile::NUM_STATES; s++) {
+                *m_profile_params[s] = prof.get_ns(gs::sync_profile::state(s));
+            }
+            *m_profile_params[gs::sync_profile::NUM_STATES] = prof.get_suspends();
+            *m_profile_params[gs::sync_profile::NUM_STATES + 1] = prof.get_unsuspends();
+        }
+    }
+
+    void log_profile()
+    {
+        gs::sync_profile& prof = m_qk->get_profile();
+        std::stringstream ss;
+        for (int s = 0; s < gs::sync_profile::NUM_STATES; s++) {
+            ss << gs::sync_profile::state_name(gs::sync_profile::state(s)) << " "
+               << prof.get_ns(gs::sync_profile::state(s)) / 1e9 << "s, ";
+        }
+        ss << prof.get_suspends() << " suspends, " << prof.get_unsuspends() << " unsuspends";
+        SCP_INFO(()) << "vCPU time breakdown: " << ss.str();
+    }
+
     /*
      * Request quantum keeper from instance
      */
@@ -130,6 +168,7 @@ protected:
     {
         for (;;) {
             wait(m_external_ev);
+            m_qk->count_io();
             set_signaled();
         }
     }
@@ -211,7 +250,8 @@ protected:
     void rearm_deadline_timer()
     {
         // This is a simple "every quantum" tick. Whether the QK makes use of it or not
-        // is down to the sync policy
+        // is down to the sync policy. The quantum may be changed at run time.
+        m_quantum_ns = int64_t(gs::tlm_quantumkeeper_extended::get_global_quantum().to_seconds() * 1e9);
         m_deadline_timer->mod(m_inst.get().get_virtual_clock() + m_quantum_ns);
     }
 
@@ -308,8 +348,21 @@ protected:
             m_inst.get().coroutine_yield();
         } else {
             std::lock_guard<std::mutex> lock(m_can_delete);
+            if (!m_placed) {
+                gs::ThreadPlacement::get().apply(gs::ThreadPlacement::VCPU, basename());
+                gs::sync_profile::set_current(&m_qk->get_profile());
+                gs::TraceExporter::get().name_thread(name());
+                m_placed = true;
+            } else if (gs::TraceExporter::get().enabled()) {
+                gs::TraceExporter::get().complete("qemu", "run", m_loop_start, gs::TraceExporter::clock::now(),
+                                                  m_loop_sc_ns);
+            }
             sync_with_kernel();
             prepare_run_cpu();
+            if (gs::TraceExporter::get().enabled()) {
+                m_loop_start = gs::TraceExporter::clock::now();
+                m_loop_sc_ns = gs::TraceExporter::sc_now_ns();
+            }
         }
     }
 
@@ -329,6 +382,7 @@ protected:
 
 public:
     cci::cci_param<unsigned int> p_gdb_port;
+    cci::cci_param<uint64_t> p_profile_interval_us;
 
     /* The default memory socket. Mapped to the default CPU address space in QEMU */
     QemuInitiatorSocket<> socket;
@@ -344,6 +398,8 @@ public:
         , m_qemu_kick_ev(false)
         , m_signaled(false)
         , p_gdb_port("gdb_port", 0, "Wait for gdb connection on TCP port <gdb_port>")
+        , p_profile_interval_us("profile_interval_us", 0,
+                                "Simulated time between updates of the profile_* parameters (0 disables them)")
         , socket("mem", *this, inst)
     {
         using namespace std::placeholders;
@@ -362,6 +418,18 @@ public:
             SC_THREAD(watch_external_ev);
         }
 
+        if (p_profile_interval_us) {
+            for (int s = 0; s < gs::sync_profile::NUM_STATES; s++) {
+                std::string n = std::string("profile_") + gs::sync_profile::state_name(gs::sync_profile::state(s)) +
+                                "_ns";
+                m_profile_params.emplace_back(new cci::cci_param<uint64_t>(n, 0, "Wall clock time of the vCPU thread"));
+            }
+            m_profile_params.emplace_back(new cci::cci_param<uint64_t>("profile_suspends", 0, "sc_suspend_all calls"));
+            m_profile_params.emplace_back(
+                new cci::cci_param<uint64_t>("profile_unsuspends", 0, "sc_unsuspend_all calls"));
+            SC_THREAD(publish_profile);
+        }
+
         m_inst.add_dev(this);
     }
 
@@ -379,6 +447,10 @@ public:
         if (m_finished) return;
         m_finished = true; // assert before taking lock (for co-routines too)
 
+        if (m_placed) {
+            log_profile();
+        }
+
         if (!m_cpu.valid()) {
             /* CPU hasn't been created yet */
             return;
@@ -493,7 +565,7 @@ public:
 
     virtual void start_of_simulation() override
     {
-        m_quantum_ns = int64_t(tlm_utils::tlm_quantumkeeper::get_global_quantum().to_seconds() * 1e9);
+        m_quantum_ns = int64_t(gs::tlm_quantumkeeper_extended::get_global_quantum().to_seconds() * 1e9);
 
         QemuDevice::start_of_simulation();
         if (m_inst.get_tcg_mode() == QemuInstance::TCG_SINGLE) {
@@ -501,6 +573,8 @@ public:
                 m_qk->start();
             }
         }
+        socket.premap_dmi();
+
         if (!m_coroutines) {
             /* Prepare the CPU for its first run and release it */
             m_cpu.set_soft_stopped(false);
@@ -520,11 +594,21 @@ public:
     /* QemuInitiatorIface  */
     virtual void initiator_customize_tlm_payload(TlmPayload& payload) override
     {
-        /* Signal the other end we are a CPU */
-        payload.set_extension(&m_cpu_hint_ext);
+        m_qk->count_io();
+
+        /* Signal the other end we are a CPU. Pooled payloads already carry it. */
+        if (payload.get_extension<::QemuCpuHintTlmExtension>() != &m_cpu_hint_ext) {
+            payload.set_extension(&m_cpu_hint_ext);
+        }
     }
 
-    virtual void initiator_tidy_tlm_payload(TlmPayload& payload) override { payload.clear_extension(&m_cpu_hint_ext); }
+    virtual void initiator_tidy_tlm_payload(TlmPayload& payload) override
+    {
+        /* Payloads from the socket pool keep the extension attached */
+        if (!payload.has_mm()) {
+            payload.clear_extension(&m_cpu_hint_ext);
+        }
+    }
 
     /*
      * Called by the initiator socket just before a memory transaction.
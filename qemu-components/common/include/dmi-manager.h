@@ -147,6 +147,7 @@ public:
         qemu::MemoryRegion m_alias;
 
         bool m_installed = false;
+        uint64_t m_last_use = 0;
 
         friend std::ostream& operator<<(std::ostream& os, const DmiRegionAlias& alias);
 
@@ -198,6 +199,14 @@ public:
          * @note Must be called with the DMI manager lock held
          */
         bool is_installed() const { return m_installed; }
+
+        /**
+         * @brief Record the last time (in the owner's own time base) this alias
+         * was requested, used by the owner to choose eviction victims.
+         */
+        void touch(uint64_t stamp) { m_last_use = stamp; }
+
+        uint64_t get_last_use() const { return m_last_use; }
     };
 
 protected:
@@ -309,6 +318,9 @@ public:
 
         std::lock_guard<std::mutex> lock(m_mutex);
 
+        // Merges and the new region addition are committed at once
+        qemu::MemoryTransaction mem_transaction = m_inst.memory_transaction_new();
+
         int priority = 0;
 
         if (m_regions.size() > 0) {
@@ -45,6 +45,24 @@ public:
     }
 };
 
+/*
+ * The memory transaction exports only come with recent libqemu releases. They
+ * are called when the LibQemuExports we are built against has them, nothing is
+ * done otherwise.
+ */
+template <typename E, typename = void>
+struct MemoryTransactionExports {
+    static void begin(const E&) {}
+    static void commit(const E&) {}
+};
+
+template <typename E>
+struct MemoryTransactionExports<E, decltype((void)&E::memory_region_transaction_begin,
+                                            (void)&E::memory_region_transaction_commit)> {
+    static void begin(const E& e) { e.memory_region_transaction_begin(); }
+    static void commit(const E& e) { e.memory_region_transaction_commit(); }
+};
+
 class LibQemuInternals
 {
 private:
@@ -67,6 +85,9 @@ public:
     const LibQemuExports& exports() const { return *m_exports; };
     LibQemu& get_inst() { return m_inst; }
 
+    void memory_region_transaction_begin() const { MemoryTransactionExports<LibQemuExports>::begin(*m_exports); }
+    void memory_region_transaction_commit() const { MemoryTransactionExports<LibQemuExports>::commit(*m_exports); }
+
     void clear_callbacks(Object obj)
     {
         for (auto cb : m_cbs) {
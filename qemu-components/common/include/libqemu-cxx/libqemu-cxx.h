@@ -75,6 +75,7 @@ class SDL2Console;
 class Dcl;
 class DclOps;
 class RcuReadLock;
+class MemoryTransaction;
 
 class LibQemu
 {
@@ -122,6 +123,17 @@ public:
 
     RcuReadLock rcu_read_lock_new();
 
+    /*
+     * Group several memory region updates so that QEMU only rebuilds the
+     * flatviews once, on the outermost commit. Transactions can nest. Must
+     * be called with the iothread locked. They do nothing when the libqemu
+     * headers we are built against do not export them.
+     */
+    void memory_region_transaction_begin();
+    void memory_region_transaction_commit();
+
+    MemoryTransaction memory_transaction_new();
+
     void finish_qemu_init();
     Bus sysbus_get_default();
 
@@ -211,6 +223,22 @@ public:
     RcuReadLock& operator=(RcuReadLock&&);
 };
 
+/* RAII helper around memory_region_transaction_begin/commit */
+class MemoryTransaction
+{
+private:
+    std::shared_ptr<LibQemuInternals> m_int;
+
+public:
+    MemoryTransaction(std::shared_ptr<LibQemuInternals> internals);
+    ~MemoryTransaction();
+
+    MemoryTransaction(const MemoryTransaction&) = delete;
+    MemoryTransaction& operator=(const MemoryTransaction&) = delete;
+    MemoryTransaction(MemoryTransaction&&);
+    MemoryTransaction& operator=(MemoryTransaction&&);
+};
+
 class Object
 {
 protected:
@@ -13,19 +13,26 @@
 #include <limits>
 #include <cassert>
 #include <cinttypes>
+#include <atomic>
+#include <vector>
 
 #include <tlm>
 
 #include <libqemu-cxx/libqemu-cxx.h>
 
 #include <libgssync.h>
+#include <cciutils.h>
+#include <trace_exporter.h>
+#include <router_if.h>
 
 #include <scp/report.h>
 
 #include <qemu-instance.h>
 #include <tlm-extensions/qemu-mr-hint.h>
 #include <tlm-extensions/exclusive-access.h>
+#include <tlm-extensions/thread_safe_extension.h>
 #include <tlm_sockets_buswidth.h>
+#include <ports/payload-pool.h>
 
 class QemuInitiatorIface
 {
@@ -76,6 +83,66 @@ protected:
 
     bool m_finished = false;
 
+    // The upper limit is set within QEMU by the TBU
+    // e.g. 1k small pages for ARM.
+    // setting to 1/2 the size of the ARM TARGET_PAGE_SIZE,
+    // Comment from QEMU code:
+    /* The physical section number is ORed with a page-aligned
+     * pointer to produce the iotlb entries.  Thus it should
+     * never overflow into the page-aligned value.
+     */
+    cci::cci_param<unsigned int> p_dmi_max_aliases;
+    cci::cci_param<bool> p_dmi_premap;
+    cci::cci_param<unsigned int> p_posted_write_depth;
+
+    /* Payloads of the MMIO and posted write transactions of this socket */
+    QemuPayloadPool m_payloads;
+
+    /*
+     * Posted writes. Writes falling in one of the configured ranges
+     * (`<socket>.posted_writes.<n>.address/size`) do not wait for the SystemC
+     * side: they are pushed in a single producer/single consumer ring (the
+     * producer being the initiator thread, holding the iothread lock) and
+     * drained in order on the SystemC thread. Any other access from this
+     * socket first waits for the ring to be drained, so reads are always
+     * ordered after the writes that precede them.
+     */
+    struct posted_write {
+        uint64_t addr;
+        uint64_t val;
+        unsigned int size;
+        sc_core::sc_time when;
+    };
+    std::map<uint64_t, uint64_t> m_posted_ranges;
+    std::vector<posted_write> m_posted_ring;
+    std::atomic<uint64_t> m_posted_head{ 0 };
+    std::atomic<uint64_t> m_posted_tail{ 0 };
+    std::atomic<bool> m_posted_scheduled{ false };
+
+    /*
+     * DMI alias bookkeeping. m_dmi_clock is bumped on every DMI request, and
+     * each alias records the clock value of the last request that hit or
+     * created it. When the limit is reached, the least recently requested
+     * alias is removed first.
+     */
+    uint64_t m_dmi_clock = 0;
+    struct dmi_stats {
+        uint64_t requests = 0;
+        uint64_t hits = 0;
+        uint64_t merges = 0;
+        uint64_t evictions = 0;
+        uint64_t invalidations = 0;
+    } m_dmi_stats;
+
+    /*
+     * Address ranges [start, end] reported by the targets as safe to access
+     * from the initiator thread (see gs::ThreadSafeExtension). Only accessed
+     * with the iothread locked. A DMI invalidation (which routers also issue
+     * when their address map changes) drops the ranges it overlaps: the next
+     * access goes through SystemC again and asks the target anew.
+     */
+    std::map<uint64_t, uint64_t> m_thread_safe_ranges;
+
     std::shared_ptr<qemu::AddressSpace> m_as;
     std::shared_ptr<qemu::MemoryListener> m_listener;
 
@@ -92,6 +159,20 @@ protected:
     std::map<DmiRegionAliasKey, DmiRegionAlias::Ptr> m_dmi_aliases;
     using AliasesIterator = std::map<DmiRegionAliasKey, DmiRegionAlias::Ptr>::iterator;
 
+    /*
+     * Aliases to the memory region of a QEMU target of the same instance (see
+     * check_qemu_mr_hint), keyed by mapping address. They share the DMI
+     * aliases limit, eviction and invalidation.
+     */
+    struct MrHintAlias {
+        qemu::MemoryRegion target;
+        qemu::MemoryRegion alias;
+        uint64_t end;
+        uint64_t last_use;
+    };
+    std::map<uint64_t, MrHintAlias> m_mr_hint_aliases;
+    using MrHintAliasesIterator = typename std::map<uint64_t, MrHintAlias>::iterator;
+
     void init_payload(TlmPayload& trans, tlm::tlm_command command, uint64_t addr, uint64_t* val, unsigned int size)
     {
         trans.set_command(command);
@@ -99,6 +180,7 @@ protected:
         trans.set_data_ptr(reinterpret_cast<unsigned char*>(val));
         trans.set_data_length(size);
         trans.set_streaming_width(size);
+        trans.set_byte_enable_ptr(nullptr);
         trans.set_byte_enable_length(0);
         trans.set_dmi_allowed(false);
         trans.set_response_status(tlm::TLM_INCOMPLETE_RESPONSE);
@@ -167,6 +249,9 @@ protected:
     {
         assert(trans.is_dmi_allowed());
         tlm::tlm_dmi dmi_data;
+        uint64_t trace_addr = trans.get_address();
+        gs::TraceExporter::span trace("dmi", "request",
+                                      [trace_addr]() { return "\"addr\":" + std::to_string(trace_addr); });
 
         SCP_INFO(()) << "DMI request for address 0x" << std::hex << trans.get_address();
 
@@ -177,29 +262,28 @@ protected:
             return dmi_data;
         }
 
-        SCP_INFO(()) << "DMI Adding for address 0x" << std::hex << trans.get_address();
-
-        // The upper limit is set within QEMU by the TBU
-        // e.g. 1k small pages for ARM.
-        // setting to 1/2 the size of the ARM TARGET_PAGE_SIZE,
-        // Comment from QEMU code:
-        /* The physical section number is ORed with a page-aligned
-         * pointer to produce the iotlb entries.  Thus it should
-         * never overflow into the page-aligned value.
+        /*
+         * The aliases are mapped as RAM, QEMU would let the guest write through
+         * them. Read only grants (e.g. a ROM) stay on the I/O path.
          */
-#define MAX_MAP 250
+        if (!dmi_data.is_read_write_allowed()) {
+            SCP_INFO(()) << "DMI for address 0x" << std::hex << trans.get_address() << " is not writable, ignored";
+            return dmi_data;
+        }
+
+        SCP_INFO(()) << "DMI Adding for address 0x" << std::hex << trans.get_address();
 
         // Current function may be called by the MMIO thread which does not hold
         // any RCU read lock. This is required in case of a memory transaction
         // commit on a TCG accelerated Qemu instance
         qemu::RcuReadLock rcu_read_lock = m_inst.get().rcu_read_lock_new();
 
-        while (m_dmi_aliases.size() > MAX_MAP) {
-            auto d = m_dmi_aliases.begin();
-            std::advance(d, std::rand() % m_dmi_aliases.size());
-            SCP_INFO(()) << "KULLING 0x" << std::hex << d->first;
-            d = remove_alias(d);
-        }
+        // Evictions, merges and the new alias are committed at once, so that
+        // QEMU only rebuilds the flatviews once for this request.
+        qemu::MemoryTransaction mem_transaction = m_inst.get().memory_transaction_new();
+
+        m_dmi_clock++;
+        m_dmi_stats.requests++;
 
         uint64_t start = dmi_data.get_start_address();
         uint64_t end = dmi_data.get_end_address();
@@ -214,11 +298,14 @@ protected:
                     assert(end <= dmi->get_end());
                     assert(dmi_data.get_dmi_ptr() == dmi->get_dmi_ptr());
                     SCP_INFO(()) << "Already have region";
+                    dmi->touch(m_dmi_clock);
+                    m_dmi_stats.hits++;
                     return dmi_data;
                 }
                 uint64_t sz = dmi->get_size();
                 if (dmi->get_end() + 1 == start && dmi->get_dmi_ptr() + sz == dmi_data.get_dmi_ptr()) {
                     SCP_INFO(()) << "Merge with previous";
+                    m_dmi_stats.merges++;
                     start = dmi->get_start();
                     dmi_data.set_start_address(start);
                     dmi_data.set_dmi_ptr(dmi->get_dmi_ptr());
@@ -233,10 +320,13 @@ protected:
                     assert(end <= dmi->get_end());
                     assert(dmi_data.get_dmi_ptr() == dmi->get_dmi_ptr());
                     SCP_INFO(()) << "Already have region(2)";
+                    dmi->touch(m_dmi_clock);
+                    m_dmi_stats.hits++;
                     return dmi_data;
                 }
                 if (dmi->get_start() == end + 1 && dmi_data.get_dmi_ptr() + sz == dmi->get_dmi_ptr()) {
                     SCP_INFO(()) << "Merge with next";
+                    m_dmi_stats.merges++;
                     end = dmi->get_end();
                     dmi_data.set_end_address(end);
 
@@ -248,7 +338,11 @@ protected:
         SCP_INFO(()) << "Adding DMI for range [0x" << std::hex << dmi_data.get_start_address() << "-0x" << std::hex
                      << dmi_data.get_end_address() << "]";
 
+        /* Only once hits and merges are ruled out, so that evictions are only counted when room is needed */
+        evict_dmi_aliases();
+
         DmiRegionAlias::Ptr alias = m_inst.get_dmi_manager().get_new_region_alias(dmi_data);
+        alias->touch(m_dmi_clock);
 
         m_dmi_aliases[start] = alias;
         add_dmi_mr_alias(m_dmi_aliases[start]);
@@ -256,48 +350,229 @@ protected:
         return dmi_data;
     }
 
-    void check_qemu_mr_hint(TlmPayload& trans)
+    /*
+     * Make room for one more alias by removing the least recently requested
+     * ones. The scan is linear, but only happens once the limit is reached and
+     * the limit is small.
+     */
+    void evict_dmi_aliases()
+    {
+        while ((m_dmi_aliases.size() + m_mr_hint_aliases.size()) >= p_dmi_max_aliases &&
+               (!m_dmi_aliases.empty() || !m_mr_hint_aliases.empty())) {
+            auto victim = m_dmi_aliases.end();
+            for (auto it = m_dmi_aliases.begin(); it != m_dmi_aliases.end(); it++) {
+                if (victim == m_dmi_aliases.end() || it->second->get_last_use() < victim->second->get_last_use()) {
+                    victim = it;
+                }
+            }
+            auto mr_victim = m_mr_hint_aliases.end();
+            for (auto it = m_mr_hint_aliases.begin(); it != m_mr_hint_aliases.end(); it++) {
+                if (mr_victim == m_mr_hint_aliases.end() || it->second.last_use < mr_victim->second.last_use) {
+                    mr_victim = it;
+                }
+            }
+
+            if (mr_victim != m_mr_hint_aliases.end() &&
+                (victim == m_dmi_aliases.end() || mr_victim->second.last_use < victim->second->get_last_use())) {
+                SCP_INFO(()) << "Evicting MR alias 0x" << std::hex << mr_victim->first;
+                remove_mr_hint_alias(mr_victim);
+            } else {
+                SCP_INFO(()) << "Evicting DMI alias 0x" << std::hex << victim->first << " (last used " << std::dec
+                             << m_dmi_clock - victim->second->get_last_use() << " requests ago)";
+                remove_alias(victim);
+            }
+            m_dmi_stats.evictions++;
+        }
+    }
+
+    MrHintAliasesIterator remove_mr_hint_alias(MrHintAliasesIterator it)
+    {
+        m_r->m_root->del_subregion(it->second.alias);
+        return m_mr_hint_aliases.erase(it);
+    }
+
+    /* Return true if the access targeted a memory region of this QEMU instance */
+    bool check_qemu_mr_hint(TlmPayload& trans)
     {
         QemuMrHintTlmExtension* ext = nullptr;
         uint64_t mapping_addr;
 
         trans.get_extension(ext);
 
-        if (ext == nullptr) {
-            return;
+        if (ext == nullptr || !ext->is_valid()) {
+            return false;
         }
 
         qemu::MemoryRegion target_mr(ext->get_mr());
 
         if (target_mr.get_inst_id() != m_dev.get_inst_id()) {
-            return;
+            return false;
         }
 
         mapping_addr = trans.get_address() - ext->get_offset();
 
+        m_dmi_clock++;
+
+        auto it = m_mr_hint_aliases.find(mapping_addr);
+        if (it != m_mr_hint_aliases.end()) {
+            if (it->second.target.get_qemu_obj() == target_mr.get_qemu_obj()) {
+                /* Already mapped */
+                it->second.last_use = m_dmi_clock;
+                return true;
+            }
+        }
+
+        qemu::RcuReadLock rcu_read_lock = m_inst.get().rcu_read_lock_new();
+        qemu::MemoryTransaction mem_transaction = m_inst.get().memory_transaction_new();
+
+        if (it != m_mr_hint_aliases.end()) {
+            /* Another target is now mapped at this address */
+            remove_mr_hint_alias(it);
+        }
+
         qemu::MemoryRegion mr(m_inst.get().template object_new<qemu::MemoryRegion>());
 
         mr.init_alias(m_dev, "mr-alias", target_mr, 0, target_mr.get_size());
+        evict_dmi_aliases();
         m_r->m_root->add_subregion(mr, mapping_addr);
+
+        m_mr_hint_aliases[mapping_addr] = { target_mr, mr, mapping_addr + target_mr.get_size() - 1, m_dmi_clock };
+        return true;
+    }
+
+    bool is_posted_write(tlm::tlm_command command, uint64_t addr, unsigned int size, const MemTxAttrs& attrs)
+    {
+        if (command != tlm::TLM_WRITE_COMMAND || attrs.debug || reentrancy || m_posted_ranges.empty()) {
+            return false;
+        }
+        auto it = m_posted_ranges.upper_bound(addr);
+        if (it == m_posted_ranges.begin()) {
+            return false;
+        }
+        it--;
+        return (addr + size - 1) <= it->second;
+    }
+
+    bool posted_writes_pending() const { return m_posted_tail.load() != m_posted_head.load(); }
+
+    /* Initiator thread, iothread locked */
+    void post_write(uint64_t addr, uint64_t val, unsigned int size)
+    {
+        if (m_posted_head.load() - m_posted_tail.load() == m_posted_ring.size()) {
+            /* Ring full, apply back pressure */
+            flush_posted_writes();
+        }
+
+        uint64_t head = m_posted_head.load(std::memory_order_relaxed);
+        posted_write& w = m_posted_ring[head % m_posted_ring.size()];
+        w.addr = addr;
+        w.val = val;
+        w.size = size;
+        w.when = sc_core::sc_time_stamp() + m_initiator.initiator_get_local_time();
+        m_posted_head.store(head + 1, std::memory_order_release);
+
+        if (!m_posted_scheduled.exchange(true)) {
+            m_on_sysc.fork_on_systemc([this]() { drain_posted_writes(); });
+        }
+    }
+
+    /* SystemC thread */
+    void drain_posted_writes()
+    {
+        for (;;) {
+            for (;;) {
+                uint64_t tail = m_posted_tail.load(std::memory_order_relaxed);
+                if (tail == m_posted_head.load(std::memory_order_acquire)) break;
+                posted_write w = m_posted_ring[tail % m_posted_ring.size()];
+
+                TlmPayload& trans = *m_payloads.allocate();
+                init_payload(trans, tlm::TLM_WRITE_COMMAND, w.addr, &w.val, w.size);
+                sc_core::sc_time delay = (w.when > sc_core::sc_time_stamp()) ? w.when - sc_core::sc_time_stamp()
+                                                                             : sc_core::SC_ZERO_TIME;
+                (*this)->b_transport(trans, delay);
+                if (trans.get_response_status() != tlm::TLM_OK_RESPONSE) {
+                    SCP_WARN(()) << "Posted write to 0x" << std::hex << w.addr
+                                 << " failed: " << trans.get_response_string();
+                }
+                m_initiator.initiator_tidy_tlm_payload(trans);
+                trans.release();
+
+                m_posted_tail.store(tail + 1, std::memory_order_release);
+            }
+            m_posted_scheduled.store(false);
+            /* A write may have been posted after we found the ring empty */
+            if (!posted_writes_pending() || m_posted_scheduled.exchange(true)) break;
+        }
+    }
+
+    /* Initiator thread, iothread locked: wait for all the posted writes to be done */
+    void flush_posted_writes()
+    {
+        if (!posted_writes_pending()) return;
+
+        m_inst.get().unlock_iothread();
+        m_on_sysc.run_on_sysc([this] { drain_posted_writes(); });
+        m_inst.get().lock_iothread();
+    }
+
+    bool is_thread_safe(uint64_t addr, unsigned int len)
+    {
+        auto it = m_thread_safe_ranges.upper_bound(addr);
+        if (it == m_thread_safe_ranges.begin()) {
+            return false;
+        }
+        it--;
+        return (addr + len - 1) <= it->second;
+    }
+
+    void forget_thread_safe_ranges(uint64_t start, uint64_t end)
+    {
+        auto it = m_thread_safe_ranges.begin();
+        while (it != m_thread_safe_ranges.end()) {
+            if (it->first <= end && it->second >= start) {
+                it = m_thread_safe_ranges.erase(it);
+            } else {
+                it++;
+            }
+        }
     }
 
     void do_regular_access(TlmPayload& trans)
     {
         using sc_core::sc_time;
 
+        flush_posted_writes();
+
         uint64_t addr = trans.get_address();
         sc_time now = m_initiator.initiator_get_local_time();
 
-        m_inst.get().unlock_iothread();
-        m_on_sysc.run_on_sysc([this, &trans, &now] { (*this)->b_transport(trans, now); });
-        m_inst.get().lock_iothread();
+        if (is_thread_safe(addr, trans.get_data_length())) {
+            /* The target accepts calls from any thread, skip the SystemC round trip */
+            m_inst.get().unlock_iothread();
+            (*this)->b_transport(trans, now);
+            m_inst.get().lock_iothread();
+        } else {
+            gs::ThreadSafeExtension ts_ext;
+            trans.set_extension(&ts_ext);
+
+            m_inst.get().unlock_iothread();
+            m_on_sysc.run_on_sysc([this, &trans, &now] { (*this)->b_transport(trans, now); });
+            m_inst.get().lock_iothread();
+
+            trans.clear_extension(&ts_ext);
+            if (ts_ext.is_set() && !m_finished) {
+                SCP_INFO(()) << "Thread safe target range [0x" << std::hex << ts_ext.get_start() << "-0x"
+                             << ts_ext.get_end() << "]";
+                m_thread_safe_ranges[ts_ext.get_start()] = ts_ext.get_end();
+            }
+        }
         /*
          * Reset transaction address before dmi check (could be altered by
          * b_transport).
          */
         trans.set_address(addr);
-        check_qemu_mr_hint(trans);
-        if (trans.is_dmi_allowed()) {
+        /* A memory region of our own instance is mapped directly, not through DMI */
+        if (!check_qemu_mr_hint(trans) && trans.is_dmi_allowed()) {
             check_dmi_hint_locked(trans);
         }
 
@@ -306,6 +581,8 @@ protected:
 
     void do_debug_access(TlmPayload& trans)
     {
+        flush_posted_writes();
+
         m_inst.get().unlock_iothread();
         m_on_sysc.run_on_sysc([this, &trans] { (*this)->transport_dbg(trans); });
         m_inst.get().lock_iothread();
@@ -317,56 +594,95 @@ protected:
         (*this)->b_transport(trans, now);
     }
 
+    static MemTxResult to_mem_tx_result(tlm::tlm_response_status status)
+    {
+        switch (status) {
+        case tlm::TLM_OK_RESPONSE:
+            return qemu::MemoryRegionOps::MemTxOK;
+
+        case tlm::TLM_ADDRESS_ERROR_RESPONSE:
+            return qemu::MemoryRegionOps::MemTxDecodeError;
+
+        default:
+            return qemu::MemoryRegionOps::MemTxError;
+        }
+    }
+
     MemTxResult qemu_io_access(tlm::tlm_command command, uint64_t addr, uint64_t* val, unsigned int size,
                                MemTxAttrs attrs)
     {
-        TlmPayload trans;
         if (m_finished) return qemu::MemoryRegionOps::MemTxError;
 
-        init_payload(trans, command, addr, val, size);
+        TlmPayload& trans = *m_payloads.allocate();
+        {
+            /* Both end before the payload is tidied, which can leave the CPU loop with a longjmp */
+            gs::sync_profile::scope prof_scope(gs::sync_profile::IO);
+            gs::TraceExporter::span trace("mmio", command == tlm::TLM_READ_COMMAND ? "read" : "write",
+                                          [addr]() { return "\"addr\":" + std::to_string(addr); });
 
-        if (trans.get_extension<ExclusiveAccessTlmExtension>()) {
-            /* in the case of an exclusive access keep the iolock (and assume NO side-effects)
-             * clearly dangerous, but exclusives are not guaranteed to work on IO space anyway
-             */
-            do_direct_access(trans);
-        } else {
-            if (!m_inst.g_rec_qemu_io_lock.try_lock()) {
-                /* Allow only a single access, but handle re-entrant code,
-                 * while allowing side-effects in SystemC (e.g. calling wait)
-                 * [NB re-entrant code caused via memory listeners to
-                 * creation of memory regions (due to DMI) in some models]
-                 */
-                m_inst.get().unlock_iothread();
-                m_inst.g_rec_qemu_io_lock.lock();
-                m_inst.get().lock_iothread();
-            }
-            reentrancy++;
+            init_payload(trans, command, addr, val, size);
 
-            /* Force re-entrant code to use a direct access (safe for reentrancy with no side effects) */
-            if (reentrancy > 1) {
+            if (trans.get_extension<ExclusiveAccessTlmExtension>()) {
+                /* in the case of an exclusive access keep the iolock (and assume NO side-effects)
+                 * clearly dangerous, but exclusives are not guaranteed to work on IO space anyway
+                 */
                 do_direct_access(trans);
-            } else if (attrs.debug) {
-                do_debug_access(trans);
+            } else if (is_posted_write(command, addr, size, attrs)) {
+                post_write(addr, *val, size);
+                trans.set_response_status(tlm::TLM_OK_RESPONSE);
             } else {
-                do_regular_access(trans);
-            }
+                if (!m_inst.g_rec_qemu_io_lock.try_lock()) {
+                    /* Allow only a single access, but handle re-entrant code,
+                     * while allowing side-effects in SystemC (e.g. calling wait)
+                     * [NB re-entrant code caused via memory listeners to
+                     * creation of memory regions (due to DMI) in some models]
+                     */
+                    m_inst.get().unlock_iothread();
+                    m_inst.g_rec_qemu_io_lock.lock();
+                    m_inst.get().lock_iothread();
+                }
+                reentrancy++;
+
+                /* Force re-entrant code to use a direct access (safe for reentrancy with no side effects) */
+                if (reentrancy > 1) {
+                    do_direct_access(trans);
+                } else if (attrs.debug) {
+                    do_debug_access(trans);
+                } else {
+                    do_regular_access(trans);
+                }
 
-            reentrancy--;
-            m_inst.g_rec_qemu_io_lock.unlock();
+                reentrancy--;
+                m_inst.g_rec_qemu_io_lock.unlock();
+            }
         }
-        m_initiator.initiator_tidy_tlm_payload(trans);
 
-        switch (trans.get_response_status()) {
-        case tlm::TLM_OK_RESPONSE:
-            return qemu::MemoryRegionOps::MemTxOK;
-
-        case tlm::TLM_ADDRESS_ERROR_RESPONSE:
-            return qemu::MemoryRegionOps::MemTxDecodeError;
-
-        default:
-            return qemu::MemoryRegionOps::MemTxError;
+        ExclusiveAccessTlmExtension* excl_ext = trans.get_extension<ExclusiveAccessTlmExtension>();
+        if (excl_ext) {
+            /*
+             * A failed exclusive store leaves the CPU loop from the tidy call,
+             * without unwinding the stack: give the pool payload back first and
+             * tidy a copy on the stack.
+             */
+            TlmPayload excl;
+            excl.set_command(trans.get_command());
+            excl.set_address(trans.get_address());
+            excl.set_data_ptr(trans.get_data_ptr());
+            excl.set_data_length(trans.get_data_length());
+            excl.set_streaming_width(trans.get_streaming_width());
+            excl.set_response_status(trans.get_response_status());
+            trans.clear_extension(excl_ext);
+            excl.set_extension(excl_ext);
+            trans.release();
+
+            m_initiator.initiator_tidy_tlm_payload(excl);
+            return to_mem_tx_result(excl.get_response_status());
         }
+
+        m_initiator.initiator_tidy_tlm_payload(trans);
+        MemTxResult res = to_mem_tx_result(trans.get_response_status());
+        trans.release();
+        return res;
     }
 
 public:
@@ -385,8 +701,25 @@ public:
         , m_inst(inst)
         , m_initiator(initiator)
         , m_on_sysc(sc_core::sc_gen_unique_name("initiator_run_on_sysc"))
+        , p_dmi_max_aliases(std::string(TlmInitiatorSocket::name()) + ".dmi_max_aliases", 250,
+                            "Maximum number of DMI aliases mapped by this socket", cci::CCI_ABSOLUTE_NAME)
+        , p_dmi_premap(std::string(TlmInitiatorSocket::name()) + ".dmi_premap", false,
+                       "Request DMI for all the routers address ranges at start of simulation", cci::CCI_ABSOLUTE_NAME)
+        , p_posted_write_depth(std::string(TlmInitiatorSocket::name()) + ".posted_write_depth", 64,
+                               "Maximum number of outstanding posted writes", cci::CCI_ABSOLUTE_NAME)
     {
         SCP_DEBUG(()) << "QemuInitiatorSocket constructor";
+
+        auto broker = cci::cci_get_broker();
+        std::string base = std::string(TlmInitiatorSocket::name()) + ".posted_writes";
+        for (std::string n : gs::sc_cci_children(base.c_str())) {
+            uint64_t address = gs::cci_get<uint64_t>(broker, base + "." + n + ".address");
+            uint64_t size = gs::cci_get<uint64_t>(broker, base + "." + n + ".size");
+            if (!size) continue;
+            SCP_INFO(()) << "Posted writes for [0x" << std::hex << address << "-0x" << address + size - 1 << "]";
+            m_posted_ranges[address] = address + size - 1;
+        }
+        m_posted_ring.resize(std::max(1u, p_posted_write_depth.get_value()));
         TlmInitiatorSocket::bind(*static_cast<tlm::tlm_bw_transport_if<>*>(this));
     }
 
@@ -413,10 +746,20 @@ public:
 
     void end_of_simulation()
     {
+        /* Writes still in the ring were acknowledged to QEMU, complete them before the jobs are cancelled */
+        if (posted_writes_pending()) {
+            drain_posted_writes();
+        }
         m_finished = true;
         cancel_all();
+        SCP_INFO(()) << "DMI statistics: " << m_dmi_stats.requests << " requests, " << m_dmi_stats.hits << " hits, "
+                     << m_dmi_stats.merges << " merges, " << m_dmi_stats.evictions << " evictions, "
+                     << m_dmi_stats.invalidations << " invalidations, " << m_dmi_aliases.size() << " DMI and "
+                     << m_mr_hint_aliases.size() << " MR aliases mapped";
     }
 
+    uint64_t get_dmi_evictions() const { return m_dmi_stats.evictions; }
+
     // This could happen during void end_of_simulation() but there is a race with other units trying
     // to pull down their DMI's
     ~QemuInitiatorSocket()
@@ -456,6 +799,38 @@ public:
         m_initiator.initiator_tidy_tlm_payload(trans);
     }
 
+    /**
+     * @brief Map DMI regions up front rather than on the first access.
+     *
+     * @details The address maps of all the routers in the platform are used as
+     * a list of candidate ranges. They are only hints: each range is requested
+     * through this socket, so only what the targets reachable from here grant
+     * gets mapped, merged with its neighbours as check_dmi_hint_locked usually
+     * does. The mapping itself is done from the initiator thread, like any DMI
+     * activity.
+     *
+     * @note Must be called from the SystemC thread, typically at start of
+     * simulation. Does nothing unless the dmi_premap parameter is set.
+     */
+    void premap_dmi()
+    {
+        if (!p_dmi_premap || m_finished) return;
+
+        /* Only the router this socket is bound to shares its address space */
+        std::vector<std::pair<uint64_t, uint64_t>> ranges;
+        const tlm::tlm_bw_transport_if<>* bw = this;
+        for (auto router : gs::find_sc_objects<gs::router_if<BUSWIDTH>>()) {
+            if (!router->is_initiator_bound(bw)) continue;
+            for (auto& ti : router->get_address_map()) {
+                ranges.push_back(std::make_pair(ti.address, ti.size));
+            }
+            break;
+        }
+        SCP_INFO(()) << "DMI pre-mapping of " << ranges.size() << " candidate ranges";
+
+        m_initiator.initiator_async_run([this, ranges]() { premap_dmi_ranges(ranges); });
+    }
+
     void init_global(qemu::Device& dev)
     {
         using namespace std::placeholders;
@@ -541,6 +916,37 @@ public:
     }
 
 private:
+    void premap_dmi_ranges(const std::vector<std::pair<uint64_t, uint64_t>>& ranges)
+    {
+        if (m_finished) return;
+
+        qemu::RcuReadLock rcu_read_lock = m_inst.get().rcu_read_lock_new();
+        qemu::MemoryTransaction mem_transaction = m_inst.get().memory_transaction_new();
+
+        TlmPayload trans;
+        uint64_t temp;
+        init_payload(trans, tlm::TLM_IGNORE_COMMAND, 0, &temp, 0);
+
+        for (auto& r : ranges) {
+            uint64_t addr = r.first;
+            uint64_t last = r.first + r.second - 1;
+
+            while (addr <= last) {
+                trans.set_address(addr);
+                trans.set_dmi_allowed(true);
+                tlm::tlm_dmi dmi_data = check_dmi_hint_locked(trans);
+
+                /* Not DMI capable (e.g. a device), leave it to the I/O path */
+                if (dmi_data.get_dmi_ptr() == nullptr || dmi_data.get_end_address() < addr) break;
+                if (dmi_data.get_end_address() >= last) break;
+
+                addr = dmi_data.get_end_address() + 1;
+            }
+        }
+
+        m_initiator.initiator_tidy_tlm_payload(trans);
+    }
+
     void invalidate_single_range(sc_dt::uint64 start_range, sc_dt::uint64 end_range)
     {
         auto it = m_dmi_aliases.upper_bound(start_range);
@@ -567,10 +973,25 @@ private:
             }
 
             it = remove_alias(it);
+            m_dmi_stats.invalidations++;
 
             SCP_INFO(()) << "Invalidated region [0x" << std::hex << r->get_start() << ", 0x" << std::hex << r->get_end()
                          << "]";
         }
+
+        auto mit = m_mr_hint_aliases.upper_bound(start_range);
+        if (mit != m_mr_hint_aliases.begin()) {
+            mit--;
+        }
+        while (mit != m_mr_hint_aliases.end() && mit->first <= end_range) {
+            if (mit->second.end < start_range) {
+                mit++;
+                continue;
+            }
+            SCP_INFO(()) << "Invalidated MR alias at 0x" << std::hex << mit->first;
+            mit = remove_mr_hint_alias(mit);
+            m_dmi_stats.invalidations++;
+        }
     }
 
     std::mutex m_mutex;
@@ -580,10 +1001,14 @@ private:
     {
         std::lock_guard<std::mutex> lock(m_mutex);
 
+        qemu::RcuReadLock rcu_read_lock = m_inst.get().rcu_read_lock_new();
+        qemu::MemoryTransaction mem_transaction = m_inst.get().memory_transaction_new();
+
         SCP_INFO(()) << "Invalidating " << m_ranges.size() << " ranges";
         auto rit = m_ranges.begin();
         while (rit != m_ranges.end()) {
             invalidate_single_range(rit->first, rit->second);
+            forget_thread_safe_ranges(rit->first, rit->second);
             rit = m_ranges.erase(rit);
         }
     }
@@ -593,6 +1018,12 @@ public:
     {
         if (m_finished) return;
 
+        if (gs::TraceExporter::get().enabled()) {
+            gs::TraceExporter::get().instant("dmi", "invalidate",
+                                             "\"start\":" + std::to_string(start_range) +
+                                                 ",\"end\":" + std::to_string(end_range));
+        }
+
         {
             std::lock_guard<std::mutex> lock(m_mutex);
             SCP_INFO(()) << "DMI invalidate [0x" << std::hex << start_range << ", 0x" << std::hex << end_range << "]";
@@ -611,6 +1042,11 @@ public:
             DmiRegionAlias::Ptr r = it->second;
             it = remove_alias(it);
         }
+        auto mit = m_mr_hint_aliases.begin();
+        while (mit != m_mr_hint_aliases.end()) {
+            mit = remove_mr_hint_alias(mit);
+        }
+        m_thread_safe_ranges.clear();
     }
 };
 
@@ -0,0 +1,99 @@
+/*
+ * This file is part of libqbox
+ * Copyright (c) 2024 Qualcomm Innovation Center, Inc. All Rights Reserved.
+ *
+ * SPDX-License-Identifier: BSD-3-Clause
+ */
+
+#ifndef _LIBQBOX_PORTS_PAYLOAD_POOL_H
+#define _LIBQBOX_PORTS_PAYLOAD_POOL_H
+
+#include <mutex>
+#include <vector>
+
+#include <tlm>
+
+#include <tlm-extensions/qemu-cpu-hint.h>
+#include <tlm-extensions/qemu-mr-hint.h>
+
+/**
+ * @class QemuPayloadPool
+ *
+ * @brief TLM memory manager recycling the payloads of QEMU originated transactions
+ *
+ * @details Payloads are taken from a free list and given back to it when their
+ * reference count drops to zero, so that a steady stream of accesses does not
+ * allocate. When a payload is recycled, all its extensions are freed except:
+ *  - the CPU hint extension, owned by the CPU which is the only user of the
+ *    pool of its socket, which stays attached;
+ *  - the MR hint extension set by TlmTargetToQemuBridge, which is kept for the
+ *    next transaction in an invalid state, the bridge updates it in place.
+ *
+ * The pool is shared by the initiator thread and the SystemC thread, the free
+ * list is protected by a mutex which is in practice never contended.
+ */
+class QemuPayloadPool : public tlm::tlm_mm_interface
+{
+private:
+    std::vector<tlm::tlm_generic_payload*> m_free;
+    std::vector<tlm::tlm_generic_payload*> m_all;
+    std::mutex m_mutex;
+
+public:
+    QemuPayloadPool() = default;
+    QemuPayloadPool(const QemuPayloadPool&) = delete;
+    QemuPayloadPool& operator=(const QemuPayloadPool&) = delete;
+
+    ~QemuPayloadPool()
+    {
+        for (auto trans : m_all) {
+            delete trans;
+        }
+    }
+
+    /**
+     * @brief Return a payload with a reference already held. Call release()
+     * on it once done.
+     */
+    tlm::tlm_generic_payload* allocate()
+    {
+        tlm::tlm_generic_payload* trans;
+        {
+            std::lock_guard<std::mutex> lock(m_mutex);
+            if (m_free.empty()) {
+                trans = new tlm::tlm_generic_payload(this);
+                m_all.push_back(trans);
+            } else {
+                trans = m_free.back();
+                m_free.pop_back();
+            }
+        }
+        trans->acquire();
+        return trans;
+    }
+
+    void free(tlm::tlm_generic_payload* trans) override
+    {
+        ::QemuCpuHintTlmExtension* cpu_hint = nullptr;
+        QemuMrHintTlmExtension* mr_hint = nullptr;
+
+        trans->get_extension(cpu_hint);
+        trans->get_extension(mr_hint);
+        if (cpu_hint) trans->clear_extension(cpu_hint);
+        if (mr_hint) trans->clear_extension(mr_hint);
+
+        trans->free_all_extensions();
+        trans->reset();
+
+        if (cpu_hint) trans->set_extension(cpu_hint);
+        if (mr_hint) {
+            mr_hint->reset();
+            trans->set_extension(mr_hint);
+        }
+
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_free.push_back(trans);
+    }
+};
+
+#endif
@@ -11,6 +11,10 @@
 
 #include <functional>
 #include <cassert>
+#include <array>
+#include <atomic>
+
+#include <cci_configuration>
 
 #include <libqemu-cxx/libqemu-cxx.h>
 
@@ -35,6 +39,11 @@
  * propagation is done directly within QEMU and do not go through the SystemC
  * kernel. Note that this is only true if the GPIOs wrapped by both this socket
  * and the remote socket lie in the same QEMU instance.
+ *
+ * Otherwise level changes are queued and applied in order on the SystemC
+ * thread, without waiting for it. Setting the `sync` parameter of the socket
+ * restores the blocking behaviour, where the QEMU thread raising the GPIO only
+ * resumes once SystemC has seen the new level.
  */
 class QemuInitiatorSignalSocket : public InitiatorSignalSocket<bool>
 {
@@ -43,6 +52,55 @@ protected:
     gs::runonsysc m_on_sysc;
     QemuTargetSignalSocket* m_qemu_remote = nullptr;
 
+    /*
+     * Single producer (QEMU, serialized by the iothread lock), single consumer
+     * (SystemC) queue of pending levels.
+     */
+    static constexpr size_t QUEUE_DEPTH = 64;
+    std::array<bool, QUEUE_DEPTH> m_queue;
+    std::atomic<size_t> m_head{ 0 };
+    std::atomic<size_t> m_tail{ 0 };
+    std::atomic<bool> m_drain_scheduled{ false };
+    bool m_last_queued = false;
+    bool m_has_queued = false;
+
+    bool queue_level(bool val)
+    {
+        size_t tail = m_tail.load(std::memory_order_relaxed);
+
+        /* The last queued level is still the latest one, nothing to do */
+        if (m_has_queued && m_last_queued == val) {
+            return true;
+        }
+
+        if (tail - m_head.load(std::memory_order_acquire) == QUEUE_DEPTH) {
+            return false;
+        }
+
+        m_queue[tail % QUEUE_DEPTH] = val;
+        m_tail.store(tail + 1, std::memory_order_release);
+        m_last_queued = val;
+        m_has_queued = true;
+
+        if (!m_drain_scheduled.exchange(true, std::memory_order_acq_rel)) {
+            m_on_sysc.run_on_sysc([this] { drain_levels(); }, false);
+        }
+
+        return true;
+    }
+
+    void drain_levels()
+    {
+        m_drain_scheduled.store(false, std::memory_order_release);
+
+        size_t head = m_head.load(std::memory_order_relaxed);
+        while (head != m_tail.load(std::memory_order_acquire)) {
+            bool val = m_queue[head % QUEUE_DEPTH];
+            m_head.store(++head, std::memory_order_release);
+            (*this)->write(val);
+        }
+    }
+
     void event_cb(bool val)
     {
         if (m_qemu_remote && (m_qemu_remote->get_gpio().same_inst_as(m_proxy))) {
@@ -66,6 +124,15 @@ protected:
             return;
         }
 
+        if (!p_sync && queue_level(val)) {
+            return;
+        }
+
+        /*
+         * Synchronous delivery, or the queue is full. In the latter case the
+         * blocking call also guarantees the queued levels are applied first.
+         */
+        m_has_queued = false;
         m_proxy.get_inst().unlock_iothread();
 
         m_on_sysc.run_on_sysc([this, val] { (*this)->write(val); });
@@ -117,8 +184,13 @@ protected:
     }
 
 public:
+    cci::cci_param<bool> p_sync;
+
     QemuInitiatorSignalSocket(const char* name)
-        : InitiatorSignalSocket<bool>(name), m_on_sysc(sc_core::sc_gen_unique_name("run_on_sysc"))
+        : InitiatorSignalSocket<bool>(name)
+        , m_on_sysc(sc_core::sc_gen_unique_name("run_on_sysc"))
+        , p_sync(std::string(InitiatorSignalSocket<bool>::name()) + ".sync", false,
+                 "Wait for SystemC to see each level change before resuming QEMU", cci::CCI_ABSOLUTE_NAME)
     {
     }
 
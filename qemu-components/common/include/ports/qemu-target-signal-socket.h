@@ -11,9 +11,13 @@
 
 #include <functional>
 
+#include <scp/report.h>
+
 #include <libqemu-cxx/libqemu-cxx.h>
 
 #include <ports/target-signal-socket.h>
+#include <device.h>
+#include <qemu-gpio-batch.h>
 
 /**
  * @class QemuTargetSignalSocket
@@ -24,13 +28,47 @@
  * TargetSignalSocket<bool>. It can be connected to an sc_core::sc_port<bool>
  * or a TargetInitiatorSocket<bool>. Modifications to this socket will be
  * reported to the wrapped GPIO.
+ *
+ * Writes that do not change the level are not forwarded. The others are
+ * applied to QEMU at the next delta cycle, together with the other updates
+ * made to the same QEMU instance during the current one (see QemuGpioBatch).
+ * The instance is the one of the QemuDevice the socket belongs to; sockets
+ * outside of a QemuDevice apply the changes straight away.
  */
 class QemuTargetSignalSocket : public TargetSignalSocket<bool>
 {
 protected:
+    SCP_LOGGER(());
+
     qemu::Gpio m_gpio_in;
+    QemuGpioBatch* m_batch = nullptr;
+    bool m_level = false;
+    bool m_has_level = false;
+    uint64_t m_forwarded = 0;
+    uint64_t m_suppressed = 0;
 
-    void value_changed_cb(const bool& val) { m_gpio_in.set(val); }
+    void value_changed_cb(const bool& val)
+    {
+        if (m_has_level && m_level == val) {
+            m_suppressed++;
+            return;
+        }
+
+        m_level = val;
+        m_has_level = true;
+        m_forwarded++;
+
+        if (m_batch) {
+            m_batch->set(m_gpio_in, val);
+        } else {
+            m_gpio_in.set(val);
+        }
+    }
+
+    void end_of_simulation()
+    {
+        SCP_DEBUG(()) << m_forwarded << " level changes forwarded, " << m_suppressed << " redundant writes suppressed";
+    }
 
     void init_with_gpio(qemu::Gpio gpio)
     {
@@ -38,6 +76,14 @@ protected:
 
         m_gpio_in = gpio;
 
+        /* Sockets may be nested in vectors, look for the device up the hierarchy */
+        for (sc_core::sc_object* o = get_parent_object(); o; o = o->get_parent_object()) {
+            if (QemuDevice* dev = dynamic_cast<QemuDevice*>(o)) {
+                m_batch = &dev->get_qemu_inst().get_gpio_batch();
+                break;
+            }
+        }
+
         auto cb = std::bind(&QemuTargetSignalSocket::value_changed_cb, this, _1);
         register_value_changed_cb(cb);
     }
@@ -90,6 +136,10 @@ public:
      * @brief Force a notification on the default event
      */
     void notify() { m_proxy.notify(); }
+
+    uint64_t get_forwarded_updates() const { return m_forwarded; }
+
+    uint64_t get_suppressed_updates() const { return m_suppressed; }
 };
 
 #endif
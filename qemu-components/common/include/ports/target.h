@@ -110,7 +110,14 @@ public:
             return;
         }
 
-        trans.set_extension(new QemuMrHintTlmExtension(m_mr, addr));
+        QemuMrHintTlmExtension* hint = nullptr;
+        trans.get_extension(hint);
+        if (hint) {
+            /* Pooled payloads keep the extension from one transaction to the next */
+            hint->set(m_mr, addr);
+        } else {
+            trans.set_extension(new QemuMrHintTlmExtension(m_mr, addr));
+        }
 
         switch (res) {
         case qemu::MemoryRegionOps::MemTxOK:
@@ -0,0 +1,80 @@
+/*
+ * This file is part of libqbox
+ * Copyright (c) 2024 Qualcomm Innovation Center, Inc. All Rights Reserved.
+ *
+ * SPDX-License-Identifier: BSD-3-Clause
+ */
+
+#ifndef _LIBQBOX_QEMU_GPIO_BATCH_H
+#define _LIBQBOX_QEMU_GPIO_BATCH_H
+
+#include <utility>
+#include <vector>
+
+#include <systemc>
+
+#include <libqemu-cxx/libqemu-cxx.h>
+
+/**
+ * @class QemuGpioBatch
+ *
+ * @brief Groups the GPIO updates of a QEMU instance made during a delta cycle
+ *
+ * @details The updates are applied in order, under a single iothread lock,
+ * by a SystemC method triggered at the next delta cycle. There is one batch
+ * per QEMU instance, owned by the QemuInstance.
+ */
+class QemuGpioBatch
+{
+protected:
+    qemu::LibQemu& m_inst;
+    std::vector<std::pair<qemu::Gpio, bool>> m_pending;
+    sc_core::sc_event m_flush_ev;
+    bool m_spawned = false;
+
+    void flush()
+    {
+        if (m_pending.empty()) {
+            return;
+        }
+
+        m_inst.lock_iothread();
+        for (auto& p : m_pending) {
+            p.first.set(p.second);
+        }
+        m_inst.unlock_iothread();
+
+        m_pending.clear();
+    }
+
+public:
+    QemuGpioBatch(qemu::LibQemu& inst): m_inst(inst) {}
+
+    QemuGpioBatch(const QemuGpioBatch&) = delete;
+    QemuGpioBatch& operator=(const QemuGpioBatch&) = delete;
+
+    void set(qemu::Gpio gpio, bool lvl)
+    {
+        /* Outside of the SystemC processes (e.g. from elaboration callbacks) apply it straight away */
+        if (sc_core::sc_get_status() != sc_core::SC_RUNNING) {
+            gpio.set(lvl);
+            return;
+        }
+
+        if (!m_spawned) {
+            sc_core::sc_spawn_options opts;
+            opts.spawn_method();
+            opts.set_sensitivity(&m_flush_ev);
+            opts.dont_initialize();
+            sc_core::sc_spawn([this]() { flush(); }, sc_core::sc_gen_unique_name("qemu_gpio_batch"), &opts);
+            m_spawned = true;
+        }
+
+        if (m_pending.empty()) {
+            m_flush_ev.notify(sc_core::SC_ZERO_TIME);
+        }
+        m_pending.emplace_back(gpio, lvl);
+    }
+};
+
+#endif
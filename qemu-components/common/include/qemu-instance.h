@@ -23,6 +23,7 @@
 #include <libqemu-cxx/libqemu-cxx.h>
 
 #include <dmi-manager.h>
+#include <qemu-gpio-batch.h>
 #include <exceptions.h>
 
 #include <scp/report.h>
@@ -150,6 +151,7 @@ public:
 protected:
     qemu::LibQemu m_inst;
     QemuInstanceDmiManager m_dmi_mgr;
+    QemuGpioBatch m_gpio_batch;
 
     cci::cci_param<std::string> p_tcg_mode;
     cci::cci_param<std::string> p_sync_policy;
@@ -291,6 +293,7 @@ public:
         , m_conf_broker(cci::cci_get_broker())
         , m_inst(loader, t)
         , m_dmi_mgr(m_inst)
+        , m_gpio_batch(m_inst)
         , p_tcg_mode("tcg_mode", "MULTI", "The TCG mode required, SINGLE, COROUTINE or MULTI")
         , p_sync_policy("sync_policy", "multithread-quantum", "Synchronization Policy to use")
         , m_tcg_mode(StringToTcgMode(p_tcg_mode))
@@ -456,6 +459,8 @@ public:
      */
     QemuInstanceDmiManager& get_dmi_manager() { return m_dmi_mgr; }
 
+    QemuGpioBatch& get_gpio_batch() { return m_gpio_batch; }
+
     int number_devices() { return devices.size(); }
 
 private:
@@ -33,6 +33,18 @@ public:
         m_offset = static_cast<const QemuMrHintTlmExtension&>(ext).m_offset;
     }
 
+    /* Reuse the extension for another transaction */
+    void set(qemu::MemoryRegion mr, uint64_t offset)
+    {
+        m_mr = mr;
+        m_offset = offset;
+    }
+
+    /* Mark the extension as carrying no hint */
+    void reset() { m_mr = qemu::MemoryRegion(); }
+
+    bool is_valid() const { return m_mr.valid(); }
+
     qemu::MemoryRegion get_mr() const { return m_mr; }
     uint64_t get_offset() const { return m_offset; }
 };
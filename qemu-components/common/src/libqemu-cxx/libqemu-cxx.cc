@@ -201,6 +201,12 @@ void LibQemu::rcu_read_unlock() { m_int->exports().rcu_read_unlock(); }
 
 RcuReadLock LibQemu::rcu_read_lock_new() { return RcuReadLock(m_int); }
 
+void LibQemu::memory_region_transaction_begin() { m_int->memory_region_transaction_begin(); }
+
+void LibQemu::memory_region_transaction_commit() { m_int->memory_region_transaction_commit(); }
+
+MemoryTransaction LibQemu::memory_transaction_new() { return MemoryTransaction(m_int); }
+
 void LibQemu::coroutine_yield() { m_int->exports().coroutine_yield(); }
 
 void LibQemu::finish_qemu_init() { m_int->exports().finish_qemu_init(); }
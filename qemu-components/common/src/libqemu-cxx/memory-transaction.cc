@@ -0,0 +1,37 @@
+/*
+ *  This file is part of libqemu-cxx
+ *  Copyright (c) 2024 Qualcomm Innovation Center, Inc. All Rights Reserved.
+ *
+ * SPDX-License-Identifier: BSD-3-Clause
+ */
+
+#include <libqemu/libqemu.h>
+
+#include <libqemu-cxx/libqemu-cxx.h>
+#include <internals.h>
+
+namespace qemu {
+
+/* Without the libqemu exports, each memory region update rebuilds the flatviews on its own */
+
+MemoryTransaction::MemoryTransaction(std::shared_ptr<LibQemuInternals> internals): m_int(internals)
+{
+    m_int->memory_region_transaction_begin();
+}
+
+MemoryTransaction::~MemoryTransaction()
+{
+    if (m_int) {
+        m_int->memory_region_transaction_commit();
+    }
+}
+
+MemoryTransaction::MemoryTransaction(MemoryTransaction&& o): m_int(o.m_int) { o.m_int.reset(); }
+
+MemoryTransaction& MemoryTransaction::operator=(MemoryTransaction&& o)
+{
+    std::swap(m_int, o.m_int);
+    return *this;
+}
+
+} // namespace qemu
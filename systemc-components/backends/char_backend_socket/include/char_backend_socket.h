@@ -13,7 +13,6 @@
 #define _GS_UART_BACKEND_SOCKET_H_
 
 #include <unistd.h>
-#include <poll.h>
 #include <errno.h>
 #include <cstring>
 #include <stdio.h>
@@ -31,6 +30,7 @@
 
 #include <async_event.h>
 #include <uutils.h>
+#include <io_reactor.h>
 #include <ports/biflow-socket.h>
 #include <module_factory_registery.h>
 
@@ -54,8 +54,12 @@ public:
 #pragma message("char_backend_socket not yet implemented for WIN32")
 #endif
 
-    int m_srv_socket;
+    int m_srv_socket = -1;
     int m_socket = -1;
+    int m_connecting = -1; // client socket while its connection is in progress
+    int m_reconnect_timer = -1;
+    struct sockaddr_storage m_srv_addr;
+    socklen_t m_srv_addr_len = 0;
     uint8_t m_buf[256];
 
     void sock_setup()
@@ -88,11 +92,12 @@ public:
 
         if (p_server) {
             setup_tcp_server(ip, port);
-        } else {
-            setup_tcp_client(ip, port);
+            if (m_srv_socket >= 0) {
+                watch_server();
+            }
+        } else if (resolve_tcp_server(ip, port)) {
+            connect_client();
         }
-
-        new std::thread(&char_backend_socket::rcv_thread, this);
     }
 
     char_backend_socket(sc_core::sc_module_name name)
@@ -104,64 +109,144 @@ public:
         , socket("biflow_socket")
     {
         SCP_TRACE(()) << "char_backend_socket constructor";
+        gs::IoReactor::get();
         socket.register_b_transport(this, &char_backend_socket::writefn);
     }
 
     void end_of_elaboration() { socket.can_receive_any(); }
 
-    void* rcv_thread()
+    ~char_backend_socket()
     {
-        for (;;) {
-            if (p_server && m_socket < 0) {
-                socklen_t addr_len = sizeof(struct sockaddr_in);
-                struct sockaddr_in client_addr;
-                int flag;
-
-                m_socket = ::accept(m_srv_socket, (struct sockaddr*)&client_addr, &addr_len);
-                if (m_socket < 0) {
-                    continue;
-                }
-                sock_setup();
-
-                char str[INET_ADDRSTRLEN];
-                inet_ntop(AF_INET, &(client_addr.sin_addr), str, INET_ADDRSTRLEN);
-                int cport = ntohs(client_addr.sin_port);
-
-                SCP_DEBUG(()) << "incoming connection from  " << str << ":" << cport;
-            } else if (!p_server && m_socket < 0) {
-                SCP_DEBUG(())("Waiting for connection");
-                sleep(1);
-                setup_tcp_client(ip, port);
-                continue;
-            }
+        auto& reactor = gs::IoReactor::get();
+        reactor.remove_timer(m_reconnect_timer);
+        if (m_socket >= 0) reactor.remove_fd(m_socket);
+        if (m_srv_socket >= 0) reactor.remove_fd(m_srv_socket);
+        if (m_connecting >= 0) {
+            reactor.remove_fd(m_connecting);
+            ::close(m_connecting);
+        }
+    }
+
+    /* The handlers below run on the I/O reactor thread */
+    void watch_server()
+    {
+        gs::IoReactor::get().add_fd(m_srv_socket, gs::IoReactor::READABLE, [this](uint32_t) { accept_client(); });
+    }
+
+    void watch_socket()
+    {
+        gs::IoReactor::get().add_fd(m_socket, gs::IoReactor::READABLE, [this](uint32_t) { rcv(); });
+    }
+
+    void start_reconnect()
+    {
+        SCP_DEBUG(())("Waiting for connection");
+        m_reconnect_timer = gs::IoReactor::get().add_timer(std::chrono::seconds(1), std::chrono::seconds(0), [this]() {
+            m_reconnect_timer = -1;
+            connect_client();
+        });
+    }
+
+    /* Start a non blocking connection, completed (or retried) once the socket is writable */
+    void connect_client()
+    {
+        SCP_INFO(()) << "setting up TCP client connection to " << ip << ":" << port;
 
-            struct pollfd fd;
-            int ret;
-            fd.fd = m_socket;
-            fd.events = POLLIN;
-            if (poll(&fd, 1, 1000) == 0) {
-                continue;
+        int sock = ::socket(m_srv_addr.ss_family, SOCK_STREAM, 0);
+        if (sock < 0) {
+            SCP_ERR(()) << "socket failed: " << std::strerror(errno);
+            return;
+        }
+        ::fcntl(sock, F_SETFL, ::fcntl(sock, F_GETFL, 0) | O_NONBLOCK);
+
+        if (::connect(sock, (struct sockaddr*)&m_srv_addr, m_srv_addr_len) == 0) {
+            client_connected(sock);
+            return;
+        }
+        if (errno != EINPROGRESS) {
+            SCP_DEBUG(()) << "connect failed: " << std::strerror(errno);
+            ::close(sock);
+            start_reconnect();
+            return;
+        }
+
+        m_connecting = sock;
+        gs::IoReactor::get().add_fd(sock, gs::IoReactor::WRITABLE, [this](uint32_t) {
+            int sock = m_connecting;
+            int err = 0;
+            socklen_t len = sizeof(err);
+            if (::getsockopt(sock, SOL_SOCKET, SO_ERROR, &err, &len) < 0) {
+                err = errno;
             }
-            if (fd.revents > 0x4) {
-                close(m_socket);
-                m_socket = -1;
-                if (!p_nowait) {
-                    SCP_FATAL(())("Non waiting Socket closed");
-                } else {
-                    SCP_WARN(())("Socket closed, will wait for new connection");
-                }
-                continue;
+            gs::IoReactor::get().remove_fd(sock);
+            m_connecting = -1;
+            if (err) {
+                SCP_DEBUG(()) << "connect failed: " << std::strerror(err);
+                ::close(sock);
+                start_reconnect();
+            } else {
+                client_connected(sock);
             }
-            ret = ::read(m_socket, m_buf, 1); // We can only guarantee 1 read will work
-            if (ret > 0) {
-                for (int i = 0; i < ret; i++) {
-                    unsigned char c = m_buf[i];
-                    if (p_sigquit && c == 0x1c) {
-                        sc_core::sc_stop();
-                    }
-                    socket.enqueue(c);
+        });
+    }
+
+    void client_connected(int sock)
+    {
+        m_socket = sock;
+        sock_setup();
+        watch_socket();
+    }
+
+    void accept_client()
+    {
+        socklen_t addr_len = sizeof(struct sockaddr_in);
+        struct sockaddr_in client_addr;
+
+        int sock = ::accept(m_srv_socket, (struct sockaddr*)&client_addr, &addr_len);
+        if (sock < 0) {
+            return;
+        }
+        /* One client at a time, stop accepting until it goes away */
+        gs::IoReactor::get().remove_fd(m_srv_socket);
+        m_socket = sock;
+        sock_setup();
+
+        char str[INET_ADDRSTRLEN];
+        inet_ntop(AF_INET, &(client_addr.sin_addr), str, INET_ADDRSTRLEN);
+        int cport = ntohs(client_addr.sin_port);
+
+        SCP_DEBUG(()) << "incoming connection from  " << str << ":" << cport;
+        watch_socket();
+    }
+
+    void rcv()
+    {
+        int ret = ::read(m_socket, m_buf, sizeof(m_buf));
+        if (ret > 0) {
+            for (int i = 0; i < ret; i++) {
+                unsigned char c = m_buf[i];
+                if (p_sigquit && c == 0x1c) {
+                    gs::IoReactor::get().post([]() { sc_core::sc_stop(); });
                 }
+                socket.enqueue(c);
             }
+            return;
+        }
+        if (ret < 0 && (errno == EAGAIN || errno == EWOULDBLOCK || errno == EINTR)) {
+            return;
+        }
+
+        gs::IoReactor::get().remove_fd(m_socket);
+        close_sock();
+        if (!p_nowait) {
+            SCP_FATAL(())("Non waiting Socket closed");
+        } else {
+            SCP_WARN(())("Socket closed, will wait for new connection");
+        }
+        if (p_server) {
+            watch_server();
+        } else {
+            start_reconnect();
         }
     }
 
@@ -239,45 +324,32 @@ public:
             SCP_ERR(()) << "listen failed: " << std::strerror(errno);
             return;
         }
-        // the connection will be done in the rcv_thread
+        ::fcntl(m_srv_socket, F_SETFL, ::fcntl(m_srv_socket, F_GETFL, 0) | O_NONBLOCK);
+        // the connection will be accepted by the I/O reactor
     }
 
-    void setup_tcp_client(std::string ip, std::string port)
+    /* Resolved once, on the SystemC thread: getaddrinfo may block */
+    bool resolve_tcp_server(std::string ip, std::string port)
     {
-        int flag = 1;
         int status;
         struct addrinfo hints;
         struct addrinfo* servinfo;
 
-        SCP_INFO(()) << "setting up TCP client connection to " << ip << ":" << port;
-
-        m_socket = ::socket(AF_INET, SOCK_STREAM, 0);
-
-        if (m_socket == -1) {
-            SCP_ERR(()) << "socket failed: " << std::strerror(errno);
-            return;
-        }
-
         memset(&hints, 0, sizeof(hints));
         hints.ai_family = AF_UNSPEC;
         hints.ai_socktype = SOCK_STREAM;
 
         status = getaddrinfo(ip.c_str(), port.c_str(), &hints, &servinfo);
-        if (status == -1) {
-            SCP_ERR(()) << "getaddrinfo failed: " << std::strerror(errno);
-            close_sock();
+        if (status != 0) {
+            SCP_ERR(()) << "getaddrinfo failed: " << gai_strerror(status);
+            return false;
         }
 
-        if (::connect(m_socket, servinfo->ai_addr, servinfo->ai_addrlen) == -1) {
-            SCP_ERR(()) << "connect failed: " << std::strerror(errno);
-            freeaddrinfo(servinfo);
-            close_sock();
-        }
+        memcpy(&m_srv_addr, servinfo->ai_addr, servinfo->ai_addrlen);
+        m_srv_addr_len = servinfo->ai_addrlen;
         freeaddrinfo(servinfo);
 
-        sock_setup();
-
-        return;
+        return true;
     }
 
     void close_sock()
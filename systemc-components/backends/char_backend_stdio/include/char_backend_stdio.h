@@ -15,12 +15,12 @@
 
 #include <async_event.h>
 #include <uutils.h>
+#include <io_reactor.h>
 #include <ports/biflow-socket.h>
 #include <module_factory_registery.h>
 #include <queue>
 #include <signal.h>
 #include <termios.h>
-#include <poll.h>
 #include <regex>
 
 class char_backend_stdio : public sc_core::sc_module
@@ -31,10 +31,7 @@ protected:
     cci::cci_param<std::string> p_highlight;
 
 private:
-    bool m_running = true;
-    std::thread rcv_thread_id;
-    pthread_t rcv_pthread_id = 0;
-    std::atomic<bool> c_flag;
+    bool m_watching = false;
     SCP_LOGGER();
     std::string line;
     std::string ecmd;
@@ -47,7 +44,6 @@ public:
 #ifdef WIN32
 #pragma message("CharBackendStdio not yet implemented for WIN32")
 #endif
-    static void catch_fn(int signo) {}
 
     static void tty_reset()
     {
@@ -140,7 +136,6 @@ public:
         , p_expect("expect", "", "string of expect commands")
         , p_highlight("ansi_highlight", "", "ANSI highlight code to use for output, default bold")
         , socket("biflow_socket")
-        , c_flag(false)
     {
         SCP_TRACE(()) << "CharBackendStdio constructor";
 
@@ -169,10 +164,12 @@ public:
         gs::SigHandler::get().add_sig_handler(SIGINT, gs::SigHandler::Handler_CB::PASS);
         gs::SigHandler::get().register_handler([&](int signo) {
             if (signo == SIGINT) {
-                c_flag = true;
+                enqueue('\x03');
             }
         });
-        if (p_read_write) rcv_thread_id = std::thread(&char_backend_stdio::rcv_thread, this);
+        if (p_read_write) {
+            m_watching = gs::IoReactor::get().add_fd(0, gs::IoReactor::READABLE, [this](uint32_t) { rcv(); });
+        }
 
         socket.register_b_transport(this, &char_backend_stdio::writefn);
     }
@@ -180,47 +177,23 @@ public:
     void end_of_elaboration() { socket.can_receive_any(); }
 
     void enqueue(char c) { socket.enqueue(c); }
-    void* rcv_thread()
+    /* Runs on the I/O reactor thread */
+    void rcv()
     {
-        struct sigaction act = { 0 };
-        act.sa_handler = &catch_fn;
-        sigaction(SIGURG, &act, NULL);
-
-        rcv_pthread_id = pthread_self();
-        sigset_t set;
-        sigemptyset(&set);
-        sigaddset(&set, SIGURG);
-        pthread_sigmask(SIG_UNBLOCK, &set, NULL);
-
         int fd = 0;
+        char buf[64];
 
-        struct pollfd self_pipe_monitor;
-        self_pipe_monitor.fd = fd;
-        self_pipe_monitor.events = POLLIN;
-
-        while (m_running) {
-            int ret = poll(&self_pipe_monitor, 1, 300);
-            if ((ret == -1 && errno == EINTR) || (ret == 0) /*timeout*/) {
-                if (c_flag) {
-                    c_flag = false;
-                    enqueue('\x03');
-                }
-                continue;
-            } else if (self_pipe_monitor.revents & (POLLHUP | POLLERR | POLLNVAL)) {
-                break;
-            } else if (self_pipe_monitor.revents & POLLIN) {
-                char c;
-                int r = read(fd, &c, 1);
-                if (r == 1) {
-                    enqueue(c);
-                }
-                if (r == 0) {
-                    break;
-                }
-            }
+        int r = read(fd, buf, sizeof(buf));
+        if (r < 0 && (errno == EAGAIN || errno == EINTR)) {
+            return;
+        }
+        for (int i = 0; i < r; i++) {
+            enqueue(buf[i]);
+        }
+        if (r <= 0) {
+            /* end of input or error */
+            gs::IoReactor::get().remove_fd(fd);
         }
-
-        return NULL;
     }
 
     void writefn(tlm::tlm_generic_payload& txn, sc_core::sc_time& t)
@@ -242,9 +215,7 @@ public:
 
     ~char_backend_stdio()
     {
-        m_running = false;
-        if (rcv_pthread_id) pthread_kill(rcv_pthread_id, SIGURG);
-        if (rcv_thread_id.joinable()) rcv_thread_id.join();
+        if (m_watching) gs::IoReactor::get().remove_fd(0);
     }
 };
 extern "C" void module_register();
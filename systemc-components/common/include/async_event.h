@@ -14,23 +14,35 @@
 #include <tlm>
 #include <thread>
 #include <mutex>
+#include <atomic>
+#include <limits>
 
 #include <pre_suspending_sc_support.h>
 
 namespace gs {
+/*
+ * Notifications from other threads are coalesced: whatever the number of
+ * async notifies, at most one kernel update is pending per event, and the
+ * event is notified with the earliest of the requested delays.
+ */
 class async_event : public sc_core::sc_prim_channel, public sc_core::sc_event
 {
 private:
-    sc_core::sc_time m_delay;
+    static constexpr sc_dt::uint64 NO_DELAY = std::numeric_limits<sc_dt::uint64>::max();
+
     std::thread::id tid;
-    std::mutex mutex; // Belt and braces
-    bool outstanding;
+    std::atomic<bool> outstanding;
+    std::atomic<sc_dt::uint64> m_delay; // earliest requested delay, NO_DELAY if none
+
+    /* Statistics, see get_async_notifies() */
+    std::atomic<uint64_t> m_async_notifies;
+    std::atomic<uint64_t> m_async_updates;
 
 public:
-    async_event(bool start_attached = true): outstanding(0)
+    async_event(bool start_attached = true)
+        : outstanding(false), m_delay(NO_DELAY), m_async_notifies(0), m_async_updates(0)
     {
         tid = std::this_thread::get_id();
-        outstanding = false;
         enable_attach_suspending(start_attached);
     }
 
@@ -41,17 +53,37 @@ public:
         if (tid == std::this_thread::get_id()) {
             sc_core::sc_event::notify(delay);
         } else {
-            mutex.lock();
-            m_delay = delay;
-            outstanding = true;
-            mutex.unlock();
-            async_request_update();
+            m_async_notifies.fetch_add(1, std::memory_order_relaxed);
+
+            sc_dt::uint64 d = delay.value();
+            sc_dt::uint64 cur = m_delay.load();
+            while (d < cur && !m_delay.compare_exchange_weak(cur, d)) {
+            }
+
+            /* Only the first notify since the last update reaches the kernel */
+            if (!outstanding.exchange(true)) {
+                m_async_updates.fetch_add(1, std::memory_order_relaxed);
+                async_request_update();
 #ifndef SC_HAS_SUSPENDING
-            sc_core::sc_internal_async_wakeup();
+                sc_core::sc_internal_async_wakeup();
 #endif
+            }
         }
     }
 
+    /**
+     * @brief Number of notifies received from other threads so far.
+     *
+     * Sampled at two points in time, it gives the notify rate of the event.
+     */
+    uint64_t get_async_notifies() const { return m_async_notifies.load(std::memory_order_relaxed); }
+
+    /**
+     * @brief Number of kernel updates requested so far, the difference with
+     * get_async_notifies() is the number of coalesced notifies.
+     */
+    uint64_t get_async_updates() const { return m_async_updates.load(std::memory_order_relaxed); }
+
     void async_attach_suspending()
     {
 #ifndef SC_HAS_ASYNC_ATTACH_SUSPENDING
@@ -78,13 +110,12 @@ public:
 private:
     void update(void)
     {
-        mutex.lock();
         // we should be in SystemC thread
-        if (outstanding) {
-            sc_event::notify(m_delay);
-            outstanding = false;
+        outstanding.store(false);
+        sc_dt::uint64 d = m_delay.exchange(NO_DELAY);
+        if (d != NO_DELAY) {
+            sc_event::notify(sc_core::sc_time::from_value(d));
         }
-        mutex.unlock();
     }
     void start_of_simulation()
     {
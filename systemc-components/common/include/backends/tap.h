@@ -7,23 +7,21 @@
 
 #pragma once
 
-#include <mutex>
 #include <queue>
 
 #include <backends/net-backend.h>
 
-#include <async_event.h>
+#include <systemc>
 
 class NetworkBackendTap : public NetworkBackend, public sc_core::sc_module
 {
 private:
-    gs::async_event m_event;
+    sc_core::sc_event m_event;
     std::queue<Payload*> m_queue;
-    std::mutex m_mutex;
     int m_fd;
 
     void open(std::string& tun);
-    void* rcv_thread();
+    void read_frames();
     void rcv();
     void close();
 
@@ -0,0 +1,141 @@
+/*
+ * Copyright (c) 2024 Qualcomm Innovation Center, Inc. All Rights Reserved.
+ *
+ * SPDX-License-Identifier: BSD-3-Clause
+ */
+
+#ifndef _GREENSOCS_BASE_COMPONENTS_IO_REACTOR_H
+#define _GREENSOCS_BASE_COMPONENTS_IO_REACTOR_H
+
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <functional>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <set>
+#include <thread>
+#include <vector>
+
+#include <systemc>
+
+#include <scp/report.h>
+
+#include <async_event.h>
+
+namespace gs {
+
+/**
+ * @brief Singleton running one host thread which waits for the file descriptors and timers of all
+ * the backends (epoll, eventfd and timerfd on Linux, poll elsewhere), instead of each backend
+ * polling from its own thread.
+ *
+ * fd and timer handlers run on the reactor thread: they should only do the host side work (read
+ * the data, accept a connection...) and hand the result to the simulation with post(), which runs
+ * jobs on the SystemC thread through a single async event. File descriptors are level triggered,
+ * and handlers may see spurious readiness, so they are expected to use non blocking reads where
+ * possible.
+ *
+ * The singleton must first be obtained on the SystemC thread during elaboration (typically from a
+ * module constructor), as it creates the SystemC side of the channel. The other methods are safe to
+ * call from any thread, including from a handler.
+ */
+class IoReactor
+{
+    SCP_LOGGER((), "IoReactor");
+
+public:
+    /* fd events */
+    static constexpr uint32_t READABLE = 1;
+    static constexpr uint32_t WRITABLE = 2;
+    static constexpr uint32_t HANGUP = 4; // hang up or error, always reported
+
+    using fd_handler = std::function<void(uint32_t events)>;
+    using timer_handler = std::function<void()>;
+
+    static IoReactor& get();
+
+    IoReactor(IoReactor const&) = delete;
+    void operator=(IoReactor const&) = delete;
+
+    ~IoReactor();
+
+    /**
+     * Call `handler` on the reactor thread whenever `fd` has one of `events` pending (or hangs up).
+     * Returns false if the fd cannot be watched.
+     */
+    bool add_fd(int fd, uint32_t events, fd_handler handler);
+
+    /** Stop watching `fd`. Once it returns, the handler is not running (unless called from it). */
+    void remove_fd(int fd);
+
+    /**
+     * Call `handler` on the reactor thread after `delay`, then every `period` if not zero.
+     * Returns an id for remove_timer(), or -1 on failure.
+     */
+    int add_timer(std::chrono::nanoseconds delay, std::chrono::nanoseconds period, timer_handler handler);
+
+    /** Cancel a timer. Once it returns, the handler is not running (unless called from it). */
+    void remove_timer(int id);
+
+    /** Run `job` on the SystemC thread. Jobs posted together are run in one kernel update. */
+    void post(std::function<void()> job);
+
+    /**
+     * Keep the simulation alive while waiting for posted jobs, for the backends which receive
+     * input from the host (e.g. a tap device). Calls are counted: the simulation may starve again
+     * once each attach() is matched by a detach(). To be called on the SystemC thread.
+     */
+    void attach();
+    void detach();
+
+    const char* name() const { return "IoReactor"; }
+
+private:
+    using clock = std::chrono::steady_clock;
+
+    static constexpr uint64_t TIMER_KEY = uint64_t(1) << 32;
+    static constexpr uint64_t WAKE_KEY = uint64_t(1) << 33;
+    static constexpr uint64_t NO_KEY = ~uint64_t(0);
+
+    struct source {
+        int fd = -1; // watched fd, or the timerfd of a timer
+        uint32_t events = 0;
+        fd_handler on_fd;
+        timer_handler on_timer;
+        clock::time_point deadline;
+        std::chrono::nanoseconds period{ 0 };
+    };
+
+    IoReactor();
+
+    void loop();
+    void dispatch(uint64_t key, uint32_t events);
+    void remove(uint64_t key);
+    void wake();
+    void run_posted();
+
+    std::map<uint64_t, std::shared_ptr<source>> m_sources;
+    std::set<uint64_t> m_always_ready; // fds which cannot be waited for (regular files)
+    uint64_t m_dispatching = NO_KEY;
+    int m_next_timer = 0;
+    std::mutex m_mutex;
+    std::condition_variable m_dispatch_done;
+
+    int m_epfd = -1;
+    int m_wake_fd[2] = { -1, -1 }; // eventfd (both ends) on Linux, a pipe elsewhere
+    std::atomic<bool> m_stop{ false };
+    std::thread m_thread;
+
+    /* SystemC side */
+    std::vector<std::function<void()>> m_posted;
+    std::mutex m_posted_mutex;
+    async_event* m_sysc_event;
+    int m_attached = 0;
+};
+
+} // namespace gs
+
+#endif // _GREENSOCS_BASE_COMPONENTS_IO_REACTOR_H
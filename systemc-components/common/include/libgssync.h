@@ -8,8 +8,11 @@
 #include "async_event.h"
 #include "qk_factory.h"
 #include "qkmultithread.h"
+#include "sync_profile.h"
 #include "qkmulti-quantum.h"
 #include "qkmulti-rolling.h"
+#include "qkmulti-lookahead.h"
+#include "qkmulti-distributed.h"
 #include "qkmulti-adaptive.h"
 #include "qkmulti-unconstrained.h"
 #include "qkmulti-freerunning.h"
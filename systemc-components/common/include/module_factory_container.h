@@ -22,6 +22,8 @@
 
 #include <libgsutils.h>
 #include <libgssync.h>
+#include <thread_placement.h>
+#include <trace_exporter.h>
 
 #include <ports/target-signal-socket.h>
 #include <ports/initiator-signal-socket.h>
@@ -498,6 +500,10 @@ public:
     {
         SCP_DEBUG(()) << "ContainerBase Constructor";
 
+        /* The host services read their configuration on the SystemC thread, before any model starts a thread */
+        gs::ThreadPlacement::init();
+        gs::TraceExporter::init();
+
         initiator_sockets.init(p_tlm_initiator_ports_num.get_value(),
                                [this](const char* n, int i) { return new tlm_initiator_socket_type(n); });
         target_sockets.init(p_tlm_target_ports_num.get_value(),
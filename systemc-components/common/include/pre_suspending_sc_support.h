@@ -20,6 +20,10 @@
 #define SC_HAS_SUSPENDING
 #endif
 
+#if SYSTEMC_VERSION >= 20240329 // SystemC 3.0.0 (IEEE 1666-2023)
+#define SC_HAS_STAGE_CALLBACKS
+#endif
+
 #ifndef SC_HAS_SUSPENDING
 
 #include <map>
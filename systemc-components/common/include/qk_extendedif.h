@@ -18,6 +18,7 @@
 #include <scp/report.h>
 
 #include <libgsutils.h>
+#include <sync_profile.h>
 
 namespace gs {
 
@@ -58,6 +59,24 @@ public:
 
     virtual SyncPolicy::Type get_thread_type() const { return SyncPolicy::SYSTEMC_THREAD; }
 
+    // Activity counters, cumulative since construction. Only the OS_THREAD
+    // policies maintain them.
+    struct sync_stats {
+        uint64_t syncs = 0;   // calls to sync()
+        uint64_t waits = 0;   // calls to sync() that ran out of budget
+        uint64_t wait_ns = 0; // wall clock time spent waiting for budget
+        uint64_t idle_ns = 0; // wall clock time spent stopped (nothing to run)
+        uint64_t io = 0;      // accesses and interrupts reported with count_io()
+    };
+
+    virtual sync_stats get_sync_stats() const { return sync_stats(); }
+
+    // time breakdown of the thread driving this quantum keeper, see sync_profile
+    sync_profile& get_profile() { return m_profile; }
+
+    // called by the initiator for each interaction with the rest of the platform
+    virtual void count_io() {}
+
     // non-const need_sync as some sync policies need a non-const version
     virtual bool need_sync() { return tlm_utils::tlm_quantumkeeper::need_sync(); }
 
@@ -70,6 +89,16 @@ public:
     // NB, the following function is only for the convenience of
     // the 'old' sync policys. This can/should be removed.
     virtual void run_on_systemc(std::function<void()> job) { job(); }
+
+    // The global quantum may change while the simulation runs (see
+    // quantum_controller) and is read from the OS threads: use these rather
+    // than the tlm_quantumkeeper ones, which are not thread safe. Setting it
+    // is done on the SystemC thread, and updates both.
+    static sc_core::sc_time get_global_quantum();
+    static void set_global_quantum(const sc_core::sc_time& q);
+
+protected:
+    sync_profile m_profile;
 };
 } // namespace gs
 
@@ -19,7 +19,7 @@ class tlm_quantumkeeper_multi_adaptive : public tlm_quantumkeeper_multithread
     {
         if (status != RUNNING) return sc_core::SC_ZERO_TIME;
 
-        sc_core::sc_time m_quantum = tlm_utils::tlm_quantumkeeper::get_global_quantum();
+        sc_core::sc_time m_quantum = tlm_quantumkeeper_extended::get_global_quantum();
         sc_core::sc_time sct = sc_core::sc_time_stamp();
         sc_core::sc_time rmt = get_current_time();
         if (rmt <= sct) {
@@ -0,0 +1,143 @@
+/*
+ * Copyright (c) 2024 Qualcomm Innovation Center, Inc. All Rights Reserved.
+ *
+ * SPDX-License-Identifier: BSD-3-Clause
+ */
+
+#ifndef QKMULTI_DISTRIBUTED_H
+#define QKMULTI_DISTRIBUTED_H
+
+#include <atomic>
+#include <condition_variable>
+#include <cstdint>
+#include <limits>
+#include <mutex>
+#include <thread>
+
+#include <qkmulti-quantum.h>
+#include <rpc_shmem_channel.h>
+
+/* Relies on the stage callbacks of SystemC 3.0 */
+#ifdef SC_HAS_STAGE_CALLBACKS
+namespace gs {
+/*
+ * Keeps the SystemC kernels of two processes, connected by a PassRPC bridge,
+ * within one quantum of each other. Each side publishes its SystemC time in
+ * the shared memory channel of the bridge after each delta and before each
+ * time step. The local time of this quantum keeper is the time of the other
+ * side plus the quantum: the other process plays the part of the vCPU thread,
+ * and the kernel is suspended when it gets a quantum ahead of it. While
+ * suspended, a host thread waits for the other side to publish a new time.
+ *
+ * A side which does not run this policy does not hold the other one back.
+ */
+class tlm_quantumkeeper_multi_distributed : public tlm_quantumkeeper_multi_quantum,
+                                            public sc_core::sc_stage_callback_if
+{
+private:
+    /* Time stamps are exchanged in picoseconds plus one, 0 when not published yet */
+    static constexpr uint64_t NOT_CLOCKED = 0;
+    static constexpr uint64_t UNBOUNDED = std::numeric_limits<uint64_t>::max();
+
+    RpcShmemChannel* m_chan = nullptr;
+    uint64_t m_published = NOT_CLOCKED;
+    std::atomic<bool> m_unbounded{ false };
+
+    /* Suspensions, with the time of the other side seen by the last one */
+    uint64_t m_suspends = 0;
+    uint64_t m_seen = NOT_CLOCKED;
+    std::thread m_watcher;
+    std::mutex m_watch_mutex;
+    std::condition_variable m_watch_cond;
+    std::atomic<bool> m_watch_stop{ false };
+
+    void publish()
+    {
+        if (!m_chan || m_unbounded) return;
+        uint64_t t = uint64_t(sc_core::sc_time_stamp().to_seconds() * 1e12 + 0.5) + 1;
+        if (t != m_published) {
+            m_published = t;
+            m_chan->publish_time(t);
+        }
+    }
+
+    virtual void stage_callback(const sc_core::sc_stage& stage) override { publish(); }
+
+    virtual void sysc_suspending() override
+    {
+        /* The other side may be waiting for our time to move on */
+        publish();
+        std::lock_guard<std::mutex> lock(m_watch_mutex);
+        m_seen = m_chan ? m_chan->peer_time() : NOT_CLOCKED;
+        m_suspends++;
+        m_watch_cond.notify_one();
+    }
+
+    void watch()
+    {
+        uint64_t handled = 0;
+        std::unique_lock<std::mutex> lock(m_watch_mutex);
+        while (!m_watch_stop) {
+            if (m_suspends == handled) {
+                m_watch_cond.wait(lock);
+                continue;
+            }
+            uint64_t seen = m_seen;
+            lock.unlock();
+            m_chan->wait_peer_time(seen);
+            lock.lock();
+            if (m_chan->peer_time() != seen) {
+                handled = m_suspends;
+                m_tick.notify(sc_core::SC_ZERO_TIME);
+            }
+        }
+    }
+
+public:
+    tlm_quantumkeeper_multi_distributed()
+    {
+        sc_core::sc_register_stage_callback(*this, sc_core::SC_POST_UPDATE | sc_core::SC_PRE_TIMESTEP);
+    }
+
+    virtual ~tlm_quantumkeeper_multi_distributed()
+    {
+        stop();
+        sc_core::sc_unregister_stage_callback(*this, sc_core::SC_POST_UPDATE | sc_core::SC_PRE_TIMESTEP);
+    }
+
+    /* Exchange time stamps through `chan`, to be called on the SystemC thread before start() */
+    void attach(RpcShmemChannel* chan)
+    {
+        m_chan = chan;
+        publish();
+        m_watcher = std::thread(&tlm_quantumkeeper_multi_distributed::watch, this);
+    }
+
+    virtual void stop() override
+    {
+        if (m_chan && !m_unbounded.exchange(true)) {
+            m_chan->publish_time(UNBOUNDED); // never wait for us again
+        }
+        {
+            std::lock_guard<std::mutex> lock(m_watch_mutex);
+            m_watch_stop = true;
+            m_watch_cond.notify_one();
+        }
+        if (m_watcher.joinable() && m_watcher.get_id() != std::this_thread::get_id()) {
+            m_watcher.join();
+        }
+        tlm_quantumkeeper_multi_quantum::stop();
+    }
+
+    virtual sc_core::sc_time get_current_time() const override
+    {
+        uint64_t peer = m_chan ? m_chan->peer_time() : NOT_CLOCKED;
+        if (peer == NOT_CLOCKED || peer == UNBOUNDED) {
+            return sc_core::sc_max_time();
+        }
+        return sc_core::sc_time(double(peer - 1), sc_core::SC_PS) + tlm_quantumkeeper_extended::get_global_quantum();
+    }
+};
+} // namespace gs
+#endif // SC_HAS_STAGE_CALLBACKS
+#endif // QKMULTI_DISTRIBUTED_H
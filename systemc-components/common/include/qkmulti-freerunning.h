@@ -15,8 +15,8 @@ class tlm_quantumkeeper_freerunning : public tlm_quantumkeeper_multithread
     virtual void sync() override
     {
         if (is_sysc_thread()) {
-            assert(m_local_time >= sc_core::sc_time_stamp());
-            sc_core::sc_time t = m_local_time - sc_core::sc_time_stamp();
+            assert(get_current_time() >= sc_core::sc_time_stamp());
+            sc_core::sc_time t = get_current_time() - sc_core::sc_time_stamp();
             m_tick.notify();
             sc_core::wait(t);
         } else {
@@ -0,0 +1,103 @@
+/*
+ * Copyright (c) 2024 Qualcomm Innovation Center, Inc. All Rights Reserved.
+ *
+ * SPDX-License-Identifier: BSD-3-Clause
+ */
+
+#ifndef QKMULTI_LOOKAHEAD_H
+#define QKMULTI_LOOKAHEAD_H
+
+#include <algorithm>
+#include <atomic>
+#include <limits>
+
+#include <qkmulti-quantum.h>
+
+/* Relies on the stage callbacks of SystemC 3.0 */
+#ifdef SC_HAS_STAGE_CALLBACKS
+namespace gs {
+/*
+ * Like multithread-rolling, the budget runs up to the next SystemC event or
+ * the end of the quantum, whichever comes first. Rather than asking the
+ * SystemC thread for it on each call, the kernel publishes both after each
+ * delta and before each time step, so time_to_sync() is computed locally by
+ * the calling thread.
+ */
+class tlm_quantumkeeper_multi_lookahead : public tlm_quantumkeeper_multi_quantum, public sc_core::sc_stage_callback_if
+{
+private:
+    /* Absolute sc_time values, written by the SystemC thread only */
+    std::atomic<sc_dt::uint64> m_next_event;
+    std::atomic<sc_dt::uint64> m_boundary;
+    sc_dt::uint64 m_last_limit = 0;
+
+    void publish()
+    {
+        sc_core::sc_time now = sc_core::sc_time_stamp();
+        sc_dt::uint64 next_event;
+
+        if (sc_core::sc_pending_activity_at_current_time()) {
+            /*
+             * The next timed event is not known until the deltas are done.
+             * Keep the last one if still ahead, otherwise only the quantum
+             * bounds the budget (the SystemC side may be suspended, waiting
+             * for us to move past the current time).
+             */
+            next_event = m_next_event.load(std::memory_order_relaxed);
+            if (next_event <= now.value()) {
+                next_event = std::numeric_limits<sc_dt::uint64>::max();
+            }
+        } else if (sc_core::sc_pending_activity_at_future_time()) {
+            next_event = (now + sc_core::sc_time_to_pending_activity()).value();
+        } else {
+            next_event = std::numeric_limits<sc_dt::uint64>::max();
+        }
+        sc_dt::uint64 boundary = (now + tlm_quantumkeeper_extended::get_global_quantum()).value();
+
+        m_next_event.store(next_event, std::memory_order_release);
+        m_boundary.store(boundary, std::memory_order_release);
+
+        /* Only wake the waiting threads if they may run further */
+        sc_dt::uint64 limit = std::min(next_event, boundary);
+        if (limit > m_last_limit) {
+            budget_moved();
+        }
+        m_last_limit = limit;
+    }
+
+    virtual void stage_callback(const sc_core::sc_stage& stage) override { publish(); }
+
+public:
+    tlm_quantumkeeper_multi_lookahead(): m_next_event(0), m_boundary(0)
+    {
+        sc_core::sc_register_stage_callback(*this, sc_core::SC_POST_UPDATE | sc_core::SC_PRE_TIMESTEP);
+    }
+
+    virtual ~tlm_quantumkeeper_multi_lookahead()
+    {
+        sc_core::sc_unregister_stage_callback(*this, sc_core::SC_POST_UPDATE | sc_core::SC_PRE_TIMESTEP);
+    }
+
+    virtual void start(std::function<void()> job = nullptr) override
+    {
+        publish();
+        tlm_quantumkeeper_multi_quantum::start(job);
+    }
+
+    virtual sc_core::sc_time time_to_sync() override
+    {
+        if (status != RUNNING) return sc_core::SC_ZERO_TIME;
+
+        sc_dt::uint64 limit = std::min(m_next_event.load(std::memory_order_acquire),
+                                       m_boundary.load(std::memory_order_acquire));
+        sc_dt::uint64 now = get_current_time().value();
+        if (limit > now) {
+            return sc_core::sc_time::from_value(limit - now);
+        } else {
+            return sc_core::SC_ZERO_TIME;
+        }
+    }
+};
+} // namespace gs
+#endif // SC_HAS_STAGE_CALLBACKS
+#endif // QKMULTI_LOOKAHEAD_H
@@ -17,7 +17,7 @@ class tlm_quantumkeeper_multi_quantum : public tlm_quantumkeeper_multithread
     // In accordance with TLM-2
     virtual sc_core::sc_time time_to_sync() override
     {
-        sc_core::sc_time quantum = tlm_utils::tlm_quantumkeeper::get_global_quantum();
+        sc_core::sc_time quantum = tlm_quantumkeeper_extended::get_global_quantum();
         sc_core::sc_time next_quantum_boundary = sc_core::sc_time_stamp() + quantum;
         sc_core::sc_time now = get_current_time();
         if (next_quantum_boundary >= now) {
@@ -31,7 +31,7 @@ private:
     {
         if (status != RUNNING) return sc_core::SC_ZERO_TIME;
 
-        sc_core::sc_time quantum = tlm_utils::tlm_quantumkeeper::get_global_quantum();
+        sc_core::sc_time quantum = tlm_quantumkeeper_extended::get_global_quantum();
         sc_core::sc_time next_event = sc_core::sc_time_to_pending_activity();
         sc_core::sc_time quantum_boundary = sc_core::sc_time_stamp() + quantum - get_current_time();
         if (sc_core::sc_pending_activity_at_current_time()) {
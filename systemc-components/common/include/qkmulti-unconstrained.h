@@ -15,7 +15,7 @@ class tlm_quantumkeeper_unconstrained : public tlm_quantumkeeper_multithread
 {
     virtual sc_core::sc_time time_to_sync() override
     {
-        return tlm_utils::tlm_quantumkeeper::get_global_quantum();
+        return tlm_quantumkeeper_extended::get_global_quantum();
     }
 
     virtual bool need_sync() override { return false; }
@@ -8,6 +8,8 @@
 #ifndef QKMULTITHREAD_H
 #define QKMULTITHREAD_H
 
+#include <atomic>
+#include <chrono>
 #include <mutex>
 #include <condition_variable>
 #include <systemc>
@@ -19,6 +21,11 @@
 
 namespace gs {
 // somewhat tuned multiple threaded QK
+//
+// The local time is kept in an atomic, so that inc() and a sync() with budget
+// left do not take any lock. Out of budget, the calling thread spins for a
+// while, then parks until the SystemC side reports the budget has moved
+// (SystemC time, quantum or status changed).
 class tlm_quantumkeeper_multithread : public gs::tlm_quantumkeeper_extended
 {
     SCP_LOGGER();
@@ -27,13 +34,33 @@ class tlm_quantumkeeper_multithread : public gs::tlm_quantumkeeper_extended
     std::condition_variable cond;
     std::thread m_worker_thread;
 
+    /* Bumped each time the budget may have grown, waited on by out of budget threads */
+    std::atomic<uint64_t> m_budget_gen;
+    sc_core::sc_time m_last_sysc_time;
+    sc_core::sc_time m_last_quantum;
+
+    std::atomic<uint64_t> m_stat_syncs;
+    std::atomic<uint64_t> m_stat_waits;
+    std::atomic<uint64_t> m_stat_wait_ns;
+    std::atomic<uint64_t> m_stat_idle_ns;
+    std::atomic<uint64_t> m_stat_io;
+    std::chrono::steady_clock::time_point m_stopped_at;
+
 protected:
-    bool m_systemc_waiting;
-    bool m_extern_waiting;
+    std::atomic<bool> m_systemc_waiting;
+    std::atomic<int> m_extern_waiting;
     async_event m_tick;
 
+    /* Absolute local time, as a sc_time value */
+    std::atomic<sc_dt::uint64> m_local_ticks;
+
     virtual bool is_sysc_thread() const;
 
+    void budget_moved();
+
+    /* Called on the SystemC thread when it is about to be suspended waiting for the local time */
+    virtual void sysc_suspending() {}
+
 private:
     void timehandler();
 
@@ -61,10 +88,20 @@ public:
     /* non-const need_sync */
     virtual bool need_sync() override;
 
+    virtual sync_stats get_sync_stats() const override;
+    virtual void count_io() override { m_stat_io.fetch_add(1, std::memory_order_relaxed); }
+
+    // notified (on the SystemC thread) on start, stop and each budget change
+    const sc_core::sc_event& get_tick_event() const { return m_tick; }
+
     // only NONE, RUNNING and STOPPED will be used by the model, the rest are for debug
-    enum jobstates { NONE = 0, RUNNING = 1, STOPPED = 2, SYSC_WAITING = 4, EXT_WAITING = 8, ILLEGAL = 12 } status;
+    enum jobstates { NONE = 0, RUNNING = 1, STOPPED = 2, SYSC_WAITING = 4, EXT_WAITING = 8, ILLEGAL = 12 };
+    std::atomic<jobstates> status;
     // this function provided only for debug.
-    jobstates get_status() { return (jobstates)(status | (m_systemc_waiting << 2) | (m_extern_waiting << 3)); }
+    jobstates get_status()
+    {
+        return (jobstates)(status | (m_systemc_waiting << 2) | ((m_extern_waiting != 0) << 3));
+    }
 };
 
 static std::vector<gs::tlm_quantumkeeper_multithread*> find_all_tlm_quantumkeeper_multithread()
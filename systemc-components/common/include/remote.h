@@ -27,16 +27,19 @@
 #include <module_factory_registery.h>
 #include <module_factory_container.h>
 #include <iomanip>
+#include <cstring>
 #include <unistd.h>
 #include <condition_variable>
 #include <mutex>
 #include <thread>
 #include <algorithm>
 #include <list>
+#include <map>
 #include <vector>
 #include <atomic>
 #include <future>
 #include <queue>
+#include <deque>
 #include <utility>
 #include <type_traits>
 #include <chrono>
@@ -48,6 +51,7 @@
 #include <rpc/this_handler.h>
 #include <rpc/this_session.h>
 #include <async_event.h>
+#include <rpc_shmem_channel.h>
 #include <transaction_forwarder_if.h>
 #include <tlm_sockets_buswidth.h>
 
@@ -59,7 +63,6 @@
 
 namespace gs {
 
-// #define DMICACHE switchthis on - then you need a mutex
 /* rpc pass through should pass through ONE forward connection ? */
 
 template <unsigned int BUSWIDTH = DEFAULT_TLM_BUSWIDTH>
@@ -105,10 +108,15 @@ class PassRPC : public sc_core::sc_module, public transaction_forwarder_if<PASS>
     }
 
     using str_pairs = std::vector<std::pair<std::string, std::string>>;
-#ifdef DMICACHE
-    /* Handle local DMI cache */
-
+    /*
+     * Handle local DMI cache (see p_dmi_cache). Entries are only used with m_dmi_cache_mut held, so
+     * once an invalidation has been applied no access through the stale region is still running.
+     */
     std::map<uint64_t, tlm::tlm_dmi> m_dmi_cache;
+    std::mutex m_dmi_cache_mut;
+    std::atomic<bool> m_dmi_cache_on{ false };
+    uint32_t m_dmi_cache_gen = 0; // last generation of the remote which the cache reflects
+
     tlm::tlm_dmi* in_cache(uint64_t address)
     {
         if (m_dmi_cache.size() > 0) {
@@ -150,7 +158,6 @@ class PassRPC : public sc_core::sc_module, public transaction_forwarder_if<PASS>
             it = m_dmi_cache.erase(it);
         }
     }
-#endif
     /* RPC structure for TLM_DMI */
     struct tlm_dmi_rpc {
         std::string m_shmem_fn;
@@ -265,6 +272,146 @@ class PassRPC : public sc_core::sc_module, public transaction_forwarder_if<PASS>
         }
     };
 
+    /* Shared memory transport, see RpcShmemChannel */
+    enum shm_op : uint32_t { SHM_B_TSPT, SHM_DBG_TSPT, SHM_DMI_REQ, SHM_DMI_INV, SHM_SIGNAL, SHM_B_TSPT_POSTED };
+    using shm_msg = RpcShmemChannel::msg;
+
+    /*
+     * Message body for a transaction, followed by its data and byte enables. Those too large for the
+     * message are placed in the staging area of the reply slot instead, where the target of the
+     * transaction works on them in place.
+     */
+    struct shm_txn {
+        uint64_t m_address;
+        int32_t m_command;
+        uint32_t m_length;
+        int32_t m_response_status;
+        uint32_t m_byte_enable_length;
+        uint32_t m_streaming_width;
+        int32_t m_gp_option;
+        uint32_t m_dmi;
+        uint32_t m_staged;
+
+        double m_sc_time;
+        double m_quantum_time;
+
+        static shm_txn& of(shm_msg& m) { return *reinterpret_cast<shm_txn*>(m.body); }
+        unsigned char* data(uint8_t* staging)
+        {
+            return m_staged ? staging : reinterpret_cast<unsigned char*>(this + 1);
+        }
+
+        /* In the message itself */
+        static bool fits(tlm::tlm_generic_payload& other)
+        {
+            return sizeof(shm_txn) + other.get_data_length() + other.get_byte_enable_length() <=
+                   RpcShmemChannel::MSG_BODY_SIZE;
+        }
+        /* In the message or in a staging area of `shm` */
+        static bool fits(tlm::tlm_generic_payload& other, RpcShmemChannel* shm)
+        {
+            return fits(other) ||
+                   size_t(other.get_data_length()) + other.get_byte_enable_length() <= shm->staging_size();
+        }
+
+        /*
+         * A request carries the data of writes and the byte enables, a reply the data of reads.
+         * `staging` is the staging area of the message, if any.
+         */
+        void from_tlm(tlm::tlm_generic_payload& other, bool request, uint8_t* staging)
+        {
+            m_command = other.get_command();
+            m_address = other.get_address();
+            m_length = other.get_data_length();
+            m_response_status = other.get_response_status();
+            m_byte_enable_length = other.get_byte_enable_length();
+            m_streaming_width = other.get_streaming_width();
+            m_gp_option = other.get_gp_option();
+            m_dmi = other.is_dmi_allowed();
+            m_staged = staging && !fits(other);
+            unsigned char* buf = data(staging);
+            if (m_length && (request != other.is_read()) && other.get_data_ptr() != buf) {
+                memcpy(buf, other.get_data_ptr(), m_length);
+            }
+            if (request && m_byte_enable_length) {
+                memcpy(buf + m_length, other.get_byte_enable_ptr(), m_byte_enable_length);
+            }
+        }
+        /*
+         * The request comes from the other process: returns false, leaving `other` alone, unless its
+         * data and byte enables fit in the area which carries them.
+         */
+        bool to_tlm(tlm::tlm_generic_payload& other, uint8_t* staging, size_t staging_size)
+        {
+            uint32_t length = m_length;
+            uint32_t be_length = m_byte_enable_length;
+            bool staged = m_staged;
+            unsigned char* buf = staged ? staging : reinterpret_cast<unsigned char*>(this + 1);
+            size_t room = staged ? staging_size : RpcShmemChannel::MSG_BODY_SIZE - sizeof(shm_txn);
+            if (!buf || size_t(length) + be_length > room) return false;
+
+            other.set_command((tlm::tlm_command)(m_command));
+            other.set_address(m_address);
+            other.set_data_length(length);
+            other.set_response_status((tlm::tlm_response_status)(m_response_status));
+            other.set_byte_enable_length(be_length);
+            other.set_streaming_width(m_streaming_width);
+            other.set_gp_option((tlm::tlm_gp_option)(m_gp_option));
+            other.set_dmi_allowed(m_dmi);
+            other.set_data_ptr(buf);
+            other.set_byte_enable_ptr(be_length ? buf + length : nullptr);
+            return true;
+        }
+        void update_to_tlm(tlm::tlm_generic_payload& other, uint8_t* staging)
+        {
+            tlm::tlm_generic_payload tmp; // make use of TLM's built in update
+            m_staged = staging && !fits(other); // where from_tlm() placed the request, whatever the reply says
+            tmp.set_data_ptr(data(staging));
+            tmp.set_response_status((tlm::tlm_response_status)m_response_status);
+            tmp.set_dmi_allowed(m_dmi);
+            other.update_original_from(tmp, other.get_byte_enable_length() > 0);
+        }
+    };
+
+    /* Message body for a DMI reply */
+    struct shm_dmi {
+        char m_shmem_fn[64];
+        uint64_t m_shmem_size;
+        uint64_t m_shmem_offset;
+        uint64_t m_dmi_start_address;
+        uint64_t m_dmi_end_address;
+        int32_t m_dmi_access;
+        double m_dmi_read_latency;
+        double m_dmi_write_latency;
+
+        static shm_dmi& of(shm_msg& m) { return *reinterpret_cast<shm_dmi*>(m.body); }
+
+        void from_rpc(const tlm_dmi_rpc& r)
+        {
+            m_shmem_size = r.m_shmem_size;
+            if (r.m_shmem_fn.size() >= sizeof(m_shmem_fn)) m_shmem_size = 0; // not shareable
+            strncpy(m_shmem_fn, r.m_shmem_fn.c_str(), sizeof(m_shmem_fn) - 1);
+            m_shmem_fn[sizeof(m_shmem_fn) - 1] = '\0';
+            m_shmem_offset = r.m_shmem_offset;
+            m_dmi_start_address = r.m_dmi_start_address;
+            m_dmi_end_address = r.m_dmi_end_address;
+            m_dmi_access = r.m_dmi_access;
+            m_dmi_read_latency = r.m_dmi_read_latency;
+            m_dmi_write_latency = r.m_dmi_write_latency;
+        }
+        void to_rpc(tlm_dmi_rpc& r) const
+        {
+            r.m_shmem_fn = m_shmem_fn;
+            r.m_shmem_size = m_shmem_size;
+            r.m_shmem_offset = m_shmem_offset;
+            r.m_dmi_start_address = m_dmi_start_address;
+            r.m_dmi_end_address = m_dmi_end_address;
+            r.m_dmi_access = m_dmi_access;
+            r.m_dmi_read_latency = m_dmi_read_latency;
+            r.m_dmi_write_latency = m_dmi_write_latency;
+        }
+    };
+
     cci::cci_broker_handle m_broker;
     str_pairs m_cci_db;
     std::mutex m_cci_db_mut;
@@ -329,6 +476,10 @@ public:
     cci::cci_param<uint32_t> p_tlm_target_ports_num;
     cci::cci_param<uint32_t> p_initiator_signals_num;
     cci::cci_param<uint32_t> p_target_signals_num;
+    cci::cci_param<bool> p_shmem_transport;
+    cci::cci_param<bool> p_dmi_cache;
+    cci::cci_param<uint32_t> p_max_posted_writes;
+    cci::cci_param<uint32_t> p_shmem_staging_size;
 
 private:
     rpc::client* client = nullptr;
@@ -348,7 +499,8 @@ private:
 
     int targets_bound = 0;
 
-    // std::shared_ptr<gs::tlm_quantumkeeper_extended> m_qk;
+    /* Only with the multithread-distributed policy, see start_of_simulation() */
+    std::shared_ptr<gs::tlm_quantumkeeper_extended> m_qk;
     gs::runonsysc m_sc;
     gs::ModuleFactory::ContainerBase* m_container;
 
@@ -363,6 +515,7 @@ private:
 
     public:
         std::vector<gs::async_event> data_ready_events;
+        gs::async_event dmi_inv_done_event;
         std::vector<sc_core::sc_event> port_available_events;
         std::vector<bool> is_port_busy;
         std::condition_variable is_rpc_execed;
@@ -378,11 +531,15 @@ private:
         {
             while (!is_stopped) {
                 std::unique_lock<std::mutex> ul(rpc_execed_mut);
-                is_rpc_execed.wait_for(ul, std::chrono::milliseconds(RPC_TIMEOUT),
-                                       [this]() { return (!notifiers.empty() || is_stopped); });
+                /* stop() notifies too, so there is no need to wake up periodically */
+                is_rpc_execed.wait(ul, [this]() { return (!notifiers.empty() || is_stopped); });
+                /* Run them unlocked, the SystemC thread may queue more meanwhile */
                 while (!notifiers.empty()) {
-                    notifiers.front()();
+                    std::function<void()> notifier = std::move(notifiers.front());
                     notifiers.pop();
+                    ul.unlock();
+                    notifier();
+                    ul.lock();
                 }
                 ul.unlock();
             }
@@ -427,6 +584,31 @@ private:
 
     std::unique_ptr<trans_waiter> btspt_waiter;
 
+    /* Set once both sides joined the shared memory channel, rpclib is used until then */
+    std::atomic<RpcShmemChannel*> m_shm{ nullptr };
+
+    /*
+     * Posted writes: writes to the posted_writes ranges complete locally, the remote acknowledges them
+     * later. Over rpc, the acknowledgements are collected in batches; over the shared memory channel,
+     * the ring keeps them in order and a barrier waits for the remote to have consumed them.
+     */
+    struct posted_range {
+        uint64_t start;
+        uint64_t end;
+    };
+    struct posted_port {
+        std::deque<std::future<RPCLIB_MSGPACK::object_handle>> acks;
+        uint32_t shm_count = 0;
+    };
+    std::vector<posted_range> m_posted_ranges;
+    std::vector<posted_port> m_posted;
+    std::mutex m_posted_mut;
+
+    /* Statistics, see get_shm_calls() */
+    std::atomic<uint64_t> m_shm_calls{ 0 };
+    std::atomic<uint64_t> m_shm_posts{ 0 };
+    std::atomic<uint64_t> m_dmi_cache_hits{ 0 };
+
     template <typename... Args>
     std::future<RPCLIB_MSGPACK::object_handle> do_rpc_async_call(std::string const& func_name, Args... args)
     {
@@ -497,6 +679,303 @@ private:
         return ret;
     }
 
+    template <typename Fill, typename Reply>
+    void do_shm_call(RpcShmemChannel* shm, shm_op op, int id, Fill&& fill, Reply&& reply)
+    {
+        m_shm_calls.fetch_add(1, std::memory_order_relaxed);
+        if (!shm->call(op, id, std::forward<Fill>(fill), std::forward<Reply>(reply)) && !cancel_waiting) {
+            SCP_DEBUG(()) << name() << " PassRPC::do_shm_call() Channel with remote is closed";
+            stop_and_exit();
+        }
+    }
+
+    template <typename Fill>
+    void do_shm_post(RpcShmemChannel* shm, shm_op op, int id, Fill&& fill)
+    {
+        m_shm_posts.fetch_add(1, std::memory_order_relaxed);
+        if (!shm->post(op, id, std::forward<Fill>(fill)) && !cancel_waiting) {
+            SCP_DEBUG(()) << name() << " PassRPC::do_shm_post() Channel with remote is closed";
+            stop_and_exit();
+        }
+    }
+
+    /* Create the shared memory channel and have the other side join it, keep rpclib otherwise */
+    void open_shmem_channel()
+    {
+        std::stringstream shm_name;
+        shm_name << "/gsrpc" << std::hex << getpid() << "-" << p_sport.get_value();
+        RpcShmemChannel* shm = new RpcShmemChannel(shm_name.str(), true, p_shmem_staging_size);
+        if (shm->is_open()) {
+            shm->serve([this, shm](shm_msg& req, shm_msg* rep) { shm_serve(shm, req, rep); });
+            if (do_rpc_as<bool>(do_rpc_call("shm_chan", shm->shm_name()))) {
+                SCP_INFO(()) << "Using shared memory transport " << shm->shm_name();
+                m_shm = shm;
+                return;
+            }
+            shm->unlink();
+        }
+        SCP_INFO(()) << "Shared memory transport not available, using rpc";
+        delete shm;
+    }
+
+    /* The port of a request comes from the other process, and calls need a reply slot */
+    bool shm_request_valid(const shm_msg& req, const shm_msg* rep)
+    {
+        switch (req.op) {
+        case SHM_B_TSPT:
+        case SHM_DBG_TSPT:
+        case SHM_DMI_REQ:
+            if (!rep) return false;
+            /* fall through */
+        case SHM_B_TSPT_POSTED:
+            return req.id >= 0 && size_t(req.id) < initiator_sockets.size();
+        case SHM_SIGNAL:
+            return req.id >= 0 && size_t(req.id) < initiator_signal_sockets.size();
+        default:
+            return true;
+        }
+    }
+
+    /* Requests from the other side over the shared memory channel, served on the channel thread */
+    void shm_serve(RpcShmemChannel* shm, shm_msg& req, shm_msg* rep)
+    {
+        if (!shm_request_valid(req, rep)) {
+            SCP_FATAL(()) << name() << " malformed shared memory request " << req.op << " for port " << req.id;
+            return;
+        }
+        switch (req.op) {
+        case SHM_B_TSPT:
+        case SHM_B_TSPT_POSTED: {
+            shm_txn& txn = shm_txn::of(req);
+            tlm::tlm_generic_payload trans;
+            if (!txn.to_tlm(trans, shm->staging(req), shm->staging_size())) {
+                SCP_FATAL(()) << name() << " shared memory transaction larger than its buffer";
+                return;
+            }
+            sc_core::sc_time delay = sc_core::sc_time(txn.m_quantum_time, sc_core::SC_SEC);
+            m_sc.run_on_sysc([&] { initiator_sockets[req.id]->b_transport(trans, delay); });
+            if (!rep) {
+                if (trans.is_response_error()) {
+                    SCP_WARN(()) << name() << " posted write to 0x" << std::hex << trans.get_address() << " failed";
+                }
+                break;
+            }
+            shm_txn& ret = shm_txn::of(*rep);
+            ret.from_tlm(trans, false, shm->staging(*rep));
+            ret.m_quantum_time = delay.to_seconds();
+            break;
+        }
+        case SHM_DBG_TSPT: {
+            tlm::tlm_generic_payload trans;
+            if (!shm_txn::of(req).to_tlm(trans, shm->staging(req), shm->staging_size())) {
+                SCP_FATAL(()) << name() << " shared memory transaction larger than its buffer";
+                return;
+            }
+            initiator_sockets[req.id]->transport_dbg(trans);
+            shm_txn::of(*rep).from_tlm(trans, false, shm->staging(*rep));
+            break;
+        }
+        case SHM_DMI_REQ: {
+            tlm::tlm_generic_payload trans;
+            if (!shm_txn::of(req).to_tlm(trans, shm->staging(req), shm->staging_size())) {
+                SCP_FATAL(()) << name() << " shared memory transaction larger than its buffer";
+                return;
+            }
+            shm_dmi::of(*rep).from_rpc(get_direct_mem_ptr_rpc(req.id, trans));
+            break;
+        }
+        case SHM_DMI_INV: {
+            uint64_t range[2];
+            uint32_t gen;
+            memcpy(range, req.body, sizeof(range));
+            memcpy(&gen, req.body + sizeof(range), sizeof(gen));
+            {
+                /* In order with the ones already applied: the rest of the cache is still valid */
+                std::lock_guard<std::mutex> lg(m_dmi_cache_mut);
+                if (m_dmi_cache_gen + 1 == gen) {
+                    cache_clean(range[0], range[1]);
+                    m_dmi_cache_gen = gen;
+                }
+            }
+            invalidate_direct_mem_ptr_rpc(range[0], range[1]);
+            break;
+        }
+        case SHM_SIGNAL:
+            signal_rpc(req.id, req.body[0] != 0);
+            break;
+        default:
+            SCP_FATAL(()) << name() << " unknown shared memory request " << req.op;
+        }
+    }
+
+    /*
+     * The remote bumps its channel generation before sending an invalidation. If it moved past the
+     * invalidations already applied, one is still in flight: drop everything rather than wait for it.
+     * Called with m_dmi_cache_mut held.
+     */
+    void dmi_cache_sync(RpcShmemChannel* shm)
+    {
+        uint32_t gen = shm->peer_generation();
+        if (gen != m_dmi_cache_gen) {
+            m_dmi_cache.clear();
+            m_dmi_cache_gen = gen;
+        }
+    }
+
+    /* Serve a transaction from the DMI cache, returns false if it must go to the remote */
+    bool dmi_cache_transport(tlm::tlm_generic_payload& trans, sc_core::sc_time& delay)
+    {
+        RpcShmemChannel* shm = m_shm;
+        if (!m_dmi_cache_on || !shm) return false;
+
+        uint64_t addr = trans.get_address();
+        uint64_t len = trans.get_data_length();
+        if (!len || trans.get_byte_enable_ptr() || trans.get_streaming_width() < len) return false;
+
+        std::lock_guard<std::mutex> lg(m_dmi_cache_mut);
+        dmi_cache_sync(shm);
+        tlm::tlm_dmi* c = in_cache(addr);
+        if (!c || addr + len - 1 > c->get_end_address()) return false;
+
+        unsigned char* ptr = c->get_dmi_ptr() + (addr - c->get_start_address());
+        switch (trans.get_command()) {
+        case tlm::TLM_WRITE_COMMAND:
+            if (!c->is_write_allowed()) return false;
+            memcpy(ptr, trans.get_data_ptr(), len);
+            delay += c->get_write_latency();
+            break;
+        case tlm::TLM_READ_COMMAND:
+            if (!c->is_read_allowed()) return false;
+            memcpy(trans.get_data_ptr(), ptr, len);
+            delay += c->get_read_latency();
+            break;
+        default:
+            return false;
+        }
+        trans.set_dmi_allowed(true);
+        trans.set_response_status(tlm::TLM_OK_RESPONSE);
+        m_dmi_cache_hits.fetch_add(1, std::memory_order_relaxed);
+        return true;
+    }
+
+    /*
+     * The remote allowed DMI for a transaction: ask for the region so that the next accesses are served
+     * locally. A refusal is remembered for the page (as a region with no access) until invalidated.
+     */
+    void dmi_cache_fill(int id, tlm::tlm_generic_payload& trans)
+    {
+        RpcShmemChannel* shm = m_shm;
+        uint64_t addr = trans.get_address();
+        uint32_t gen;
+        {
+            std::lock_guard<std::mutex> lg(m_dmi_cache_mut);
+            dmi_cache_sync(shm);
+            if (in_cache(addr)) return;
+            gen = m_dmi_cache_gen;
+        }
+
+        tlm::tlm_generic_payload req;
+        tlm::tlm_dmi dmi_data;
+        req.set_command(trans.get_command());
+        req.set_address(addr);
+        req.set_data_ptr(nullptr);
+        req.set_data_length(0);
+        if (get_direct_mem_ptr(id, req, dmi_data)) return; // cached there
+
+        std::lock_guard<std::mutex> lg(m_dmi_cache_mut);
+        if (shm->peer_generation() != gen) return;
+        tlm::tlm_dmi none;
+        none.set_start_address(addr & ~uint64_t(0xfff));
+        none.set_end_address(addr | 0xfff);
+        cache_clean(none.get_start_address(), none.get_end_address());
+        m_dmi_cache[none.get_start_address()] = none;
+    }
+
+    void read_posted_ranges()
+    {
+        std::string base = std::string(name()) + ".posted_writes";
+        for (std::string n : gs::sc_cci_children(base.c_str())) {
+            uint64_t address = gs::cci_get<uint64_t>(m_broker, base + "." + n + ".address");
+            uint64_t size = gs::cci_get<uint64_t>(m_broker, base + "." + n + ".size");
+            if (!size) continue;
+            SCP_INFO(())("Posting writes to {:#x} (size: {})", address, size);
+            m_posted_ranges.push_back({ address, address + size - 1 });
+        }
+    }
+
+    bool is_posted_write(tlm::tlm_generic_payload& trans)
+    {
+        if (m_posted_ranges.empty() || !trans.is_write()) return false;
+        RpcShmemChannel* shm = m_shm;
+        if (shm && !shm_txn::fits(trans)) return false; // keep each port on one transport
+        uint64_t addr = trans.get_address();
+        uint64_t len = trans.get_data_length();
+        for (auto& r : m_posted_ranges) {
+            if (addr >= r.start && len && addr + len - 1 <= r.end) return true;
+        }
+        return false;
+    }
+
+    bool posted_full(int id)
+    {
+        /*
+         * The ring of the channel is shared by all the ports, and also carries the calls: a write is
+         * only posted if it gets in without waiting, otherwise it is sent from the waiter thread.
+         */
+        RpcShmemChannel* shm = m_shm;
+        if (shm && shm->send_room() == 0) return true;
+        std::lock_guard<std::mutex> lg(m_posted_mut);
+        return m_posted[id].acks.size() + m_posted[id].shm_count >= p_max_posted_writes;
+    }
+
+    bool has_posted(int id)
+    {
+        if (m_posted_ranges.empty()) return false;
+        std::lock_guard<std::mutex> lg(m_posted_mut);
+        return !m_posted[id].acks.empty() || m_posted[id].shm_count;
+    }
+
+    void post_write(int id, tlm::tlm_generic_payload& trans, tlm_generic_payload_rpc& t)
+    {
+        std::lock_guard<std::mutex> lg(m_posted_mut);
+        RpcShmemChannel* shm = m_shm;
+        if (shm) {
+            do_shm_post(shm, SHM_B_TSPT_POSTED, id, [&](shm_msg& m) {
+                shm_txn& txn = shm_txn::of(m);
+                txn.from_tlm(trans, true, nullptr); // one way messages have no staging area
+                txn.m_quantum_time = t.m_quantum_time;
+                txn.m_sc_time = t.m_sc_time;
+            });
+            m_posted[id].shm_count++;
+        } else {
+            m_posted[id].acks.push_back(do_rpc_async_call("b_tspt", id, t));
+        }
+        trans.set_response_status(tlm::TLM_OK_RESPONSE);
+    }
+
+    /* Ordering barrier: wait until the remote has handled the writes posted on port `id` */
+    void drain_posted(int id)
+    {
+        if (m_posted_ranges.empty()) return;
+        std::lock_guard<std::mutex> lg(m_posted_mut);
+        posted_port& p = m_posted[id];
+        if (p.shm_count) {
+            p.shm_count = 0;
+            RpcShmemChannel* shm = m_shm;
+            if (!shm->drain() && !cancel_waiting) {
+                SCP_DEBUG(()) << name() << " PassRPC::drain_posted() Channel with remote is closed";
+                stop_and_exit();
+            }
+        }
+        while (!p.acks.empty()) {
+            tlm_generic_payload_rpc r = do_rpc_async_get<tlm_generic_payload_rpc>(std::move(p.acks.front()));
+            p.acks.pop_front();
+            if (r.m_response_status != tlm::TLM_OK_RESPONSE) {
+                SCP_WARN(()) << name() << " posted write to 0x" << std::hex << r.m_address << " failed";
+            }
+        }
+    }
+
     bool is_local_mode() { return (m_container && m_is_local); }
 
     void fw_b_transport(int id, tlm::tlm_generic_payload& trans, sc_core::sc_time& delay) override
@@ -549,6 +1028,11 @@ private:
             return;
         }
 
+        bool posted = is_posted_write(trans);
+
+        // If we have a locally cached DMI, use it! (but not before posted writes it might overlap)
+        if (!posted && !has_posted(id) && dmi_cache_transport(trans, delay)) return;
+
         while (btspt_waiter->is_port_busy[id]) {
             sc_core::wait(btspt_waiter->port_available_events[id]);
         }
@@ -558,33 +1042,39 @@ private:
         tlm_generic_payload_rpc r;
         double time = sc_core::sc_time_stamp().to_seconds();
 
-        uint64_t addr = trans.get_address();
-        // If we have a locally cached DMI, use it!
-#ifdef DMICACHE
-        auto c = in_cache(addr);
-        if (c) {
-            uint64_t len = trans.get_data_length();
-            if (addr >= c->get_start_address() && addr + len <= c->get_end_address()) {
-                switch (trans.get_command()) {
-                case tlm::TLM_IGNORE_COMMAND:
-                    break;
-                case tlm::TLM_WRITE_COMMAND:
-                    memcpy(c->get_dmi_ptr() + (addr - c->get_start_address()), trans.get_data_ptr(), len);
-                    break;
-                case tlm::TLM_READ_COMMAND:
-                    memcpy(trans.get_data_ptr(), c->get_dmi_ptr() + (addr - c->get_start_address()), len);
-                    break;
-                }
-                trans.set_dmi_allowed(true);
-                trans.set_response_status(tlm::TLM_OK_RESPONSE);
-                return;
-            }
-        }
-#endif
         t.from_tlm(trans);
         t.m_quantum_time = delay.to_seconds();
         t.m_sc_time = sc_core::sc_time_stamp().to_seconds();
 
+        /* The shared memory channel, when open, carries whatever fits in a message */
+        bool by_shm = false;
+        auto call_remote = [&]() {
+            drain_posted(id);
+            if (posted) {
+                post_write(id, trans, t);
+                return;
+            }
+            RpcShmemChannel* shm = m_shm;
+            if (shm && shm_txn::fits(trans, shm)) {
+                by_shm = true;
+                do_shm_call(
+                    shm, SHM_B_TSPT, id,
+                    [&](shm_msg& m) {
+                        shm_txn& txn = shm_txn::of(m);
+                        txn.from_tlm(trans, true, shm->staging(m));
+                        txn.m_quantum_time = t.m_quantum_time;
+                        txn.m_sc_time = t.m_sc_time;
+                    },
+                    [&](shm_msg& m) {
+                        shm_txn& txn = shm_txn::of(m);
+                        txn.update_to_tlm(trans, shm->staging(m));
+                        delay = sc_core::sc_time(txn.m_quantum_time, sc_core::SC_SEC);
+                    });
+            } else {
+                r = do_rpc_as<tlm_generic_payload_rpc>(do_rpc_call("b_tspt", id, t));
+            }
+        };
+
         //        SCP_DEBUG(()) << name() << " b_transport socket ID " << id << " From_tlm " <<
         //        txn_str(trans); SCP_DEBUG(()) << getpid() <<" IS THE b_ RPC PID " <<
         //        std::this_thread::get_id() <<" is the thread ID";
@@ -596,15 +1086,18 @@ private:
          * from the async_call in a separate thread, then notify the waiting systemc thread.
          * This solution should be revisted in future.
          */
-        if (std::this_thread::get_id() == sc_tid && sc_core::sc_get_status() >= sc_core::sc_status::SC_RUNNING &&
-            sc_core::sc_get_curr_process_kind() != sc_core::sc_curr_proc_kind::SC_NO_PROC_) {
+        if (posted && !posted_full(id)) {
+            post_write(id, trans, t); // does not wait for the remote
+        } else if (std::this_thread::get_id() == sc_tid &&
+                   sc_core::sc_get_status() >= sc_core::sc_status::SC_RUNNING &&
+                   sc_core::sc_get_curr_process_kind() != sc_core::sc_curr_proc_kind::SC_NO_PROC_) {
             SCP_DEBUG(()) << name() << " B_TSPT handle reentrancy, sc_get_curr_simcontext " << sc_get_curr_simcontext()
                           << " SC current process kind = " << sc_core::sc_get_curr_process_kind();
             btspt_waiter->start();
 
             std::unique_lock<std::mutex> ul(btspt_waiter->rpc_execed_mut);
             btspt_waiter->enqueue_notifier([&]() {
-                r = do_rpc_as<tlm_generic_payload_rpc>(do_rpc_call("b_tspt", id, t));
+                call_remote();
                 btspt_waiter->data_ready_events[id].async_notify();
             });
             btspt_waiter->is_rpc_execed.notify_one();
@@ -617,12 +1110,13 @@ private:
                 SCP_FATAL(()) << name() << " b_transport was called from the context of SC_METHOD!";
             }
         } else {
-            r = do_rpc_as<tlm_generic_payload_rpc>(do_rpc_call("b_tspt", id, t));
+            call_remote();
         }
 
-        r.update_to_tlm(trans);
-        delay = sc_core::sc_time(r.m_quantum_time, sc_core::SC_SEC);
-        sc_core::sc_time other_time = sc_core::sc_time(r.m_sc_time, sc_core::SC_SEC);
+        if (!by_shm && !posted) {
+            r.update_to_tlm(trans);
+            delay = sc_core::sc_time(r.m_quantum_time, sc_core::SC_SEC);
+        }
         //        m_qk->set(other_time+delay);
         //        m_qk->sync();
         //        SCP_DEBUG(()) << name() << " update_to_tlm " << txn_str(trans);
@@ -630,6 +1124,8 @@ private:
         //        txn_str(trans);
         btspt_waiter->is_port_busy[id] = false;
         btspt_waiter->port_available_events[id].notify(sc_core::SC_ZERO_TIME);
+
+        if (m_dmi_cache_on && trans.is_dmi_allowed()) dmi_cache_fill(id, trans);
     }
     tlm_generic_payload_rpc b_transport_rpc(int id, tlm_generic_payload_rpc t)
     {
@@ -670,12 +1166,20 @@ private:
             return m_container->fw_transport_dbg(id, trans);
         }
         SCP_DEBUG(()) << name() << " ->remote debug tlm " << txn_str(trans);
+        drain_posted(id);
         tlm_generic_payload_rpc t;
         tlm_generic_payload_rpc r;
 
-        t.from_tlm(trans);
-        r = do_rpc_as<tlm_generic_payload_rpc>(do_rpc_call("dbg_tspt", id, t));
-        r.update_to_tlm(trans);
+        RpcShmemChannel* shm = m_shm;
+        if (shm && shm_txn::fits(trans, shm)) {
+            do_shm_call(
+                shm, SHM_DBG_TSPT, id, [&](shm_msg& m) { shm_txn::of(m).from_tlm(trans, true, shm->staging(m)); },
+                [&](shm_msg& m) { shm_txn::of(m).update_to_tlm(trans, shm->staging(m)); });
+        } else {
+            t.from_tlm(trans);
+            r = do_rpc_as<tlm_generic_payload_rpc>(do_rpc_call("dbg_tspt", id, t));
+            r.update_to_tlm(trans);
+        }
         SCP_DEBUG(()) << name() << " <-remote debug tlm done " << txn_str(trans);
         // this is not entirely accurate, but see below
         return trans.get_response_status() == tlm::TLM_OK_RESPONSE ? trans.get_data_length() : 0;
@@ -704,27 +1208,40 @@ private:
         if (is_local_mode()) {
             return m_container->fw_get_direct_mem_ptr(id, trans, dmi_data);
         }
-        tlm::tlm_dmi* c;
         SCP_DEBUG(()) << " " << name() << " get_direct_mem_ptr to address "
                       << "0x" << std::hex << trans.get_address();
-
-#ifdef DMICACHE
-        c = in_cache(trans.get_address());
-        if (c) {
-            //            SCP_DEBUG(()) << "In Cache " << std::hex << c->get_start_address() <<
-            //            "
-            //            - " << std::hex << c->get_end_address() ;
-            dmi_data = *c;
-            return !(dmi_data.is_none_allowed());
+        drain_posted(id);
+
+        RpcShmemChannel* shm = m_shm;
+        bool use_cache = m_dmi_cache_on && shm;
+        uint32_t gen = 0;
+        if (use_cache) {
+            std::lock_guard<std::mutex> lg(m_dmi_cache_mut);
+            dmi_cache_sync(shm);
+            tlm::tlm_dmi* c = in_cache(trans.get_address());
+            if (c && !c->is_none_allowed()) {
+                //            SCP_DEBUG(()) << "In Cache " << std::hex << c->get_start_address() <<
+                //            "
+                //            - " << std::hex << c->get_end_address() ;
+                dmi_data = *c;
+                return true;
+            }
+            gen = m_dmi_cache_gen;
         }
-#endif
+
         tlm_generic_payload_rpc t;
         tlm_dmi_rpc r;
-        t.from_tlm(trans);
-        //        SCP_DEBUG(()) << name() << " DMI socket ID " << id << " From_tlm " <<
-        //        txn_str(trans)
-        //        ;
-        r = do_rpc_as<tlm_dmi_rpc>(do_rpc_call("dmi_req", id, t));
+        if (shm && shm_txn::fits(trans, shm)) {
+            do_shm_call(
+                shm, SHM_DMI_REQ, id, [&](shm_msg& m) { shm_txn::of(m).from_tlm(trans, true, shm->staging(m)); },
+                [&](shm_msg& m) { shm_dmi::of(m).to_rpc(r); });
+        } else {
+            t.from_tlm(trans);
+            //        SCP_DEBUG(()) << name() << " DMI socket ID " << id << " From_tlm " <<
+            //        txn_str(trans)
+            //        ;
+            r = do_rpc_as<tlm_dmi_rpc>(do_rpc_call("dmi_req", id, t));
+        }
 
         if (r.m_shmem_size == 0) {
             SCP_DEBUG(()) << name() << "DMI OK, but no shared memory available?" << trans.get_address();
@@ -737,10 +1254,14 @@ private:
         r.to_tlm(dmi_data);
 //            SCP_DEBUG(()) << "Adding " << r.m_shmem_fn << " " << dmi_data.get_start_address()
 //                      << " to cache";
-#ifdef DMICACHE
-        assert(m_dmi_cache.count(dmi_data.get_start_address()) == 0);
-        m_dmi_cache[dmi_data.get_start_address()] = dmi_data;
-#endif
+        if (use_cache && !dmi_data.is_none_allowed()) {
+            /* Unless invalidated meanwhile */
+            std::lock_guard<std::mutex> lg(m_dmi_cache_mut);
+            if (shm->peer_generation() == gen) {
+                cache_clean(dmi_data.get_start_address(), dmi_data.get_end_address());
+                m_dmi_cache[dmi_data.get_start_address()] = dmi_data;
+            }
+        }
         //        }
         //        SCP_DEBUG(()) << name() << "DMI to " <<trans.get_address()<<" status "
         //        <<!(dmi_data.is_none_allowed()) <<" range " << std::hex <<
@@ -754,7 +1275,10 @@ private:
     {
         tlm::tlm_generic_payload trans;
         t.deep_copy_to_tlm(trans);
-
+        return get_direct_mem_ptr_rpc(id, trans);
+    }
+    tlm_dmi_rpc get_direct_mem_ptr_rpc(int id, tlm::tlm_generic_payload& trans)
+    {
         SCP_DEBUG(()) << " " << name() << " get_direct_mem_ptr " << txn_str(trans);
 
         tlm::tlm_dmi dmi_data;
@@ -773,30 +1297,90 @@ private:
     {
         if (is_local_mode()) {
             m_container->fw_invalidate_direct_mem_ptr(start, end);
+            return;
         }
         SCP_DEBUG(()) << " " << name() << " invalidate_direct_mem_ptr "
                       << " start address 0x" << std::hex << start << " end address 0x" << std::hex << end;
-        do_rpc_async_call("dmi_inv", start, end);
+        /*
+         * Wait for the remote to have invalidated its initiators: the caller may reuse the memory as
+         * soon as this returns.
+         */
+        auto call_remote = [&]() {
+            RpcShmemChannel* shm = m_shm;
+            if (shm) {
+                /* The new generation stops the remote from using its cached regions before it gets the message */
+                uint32_t gen = shm->bump_generation();
+                do_shm_call(
+                    shm, SHM_DMI_INV, 0,
+                    [&](shm_msg& m) {
+                        uint64_t range[2] = { start, end };
+                        memcpy(m.body, range, sizeof(range));
+                        memcpy(m.body + sizeof(range), &gen, sizeof(gen));
+                    },
+                    [](shm_msg&) {});
+                return;
+            }
+            do_rpc_call("dmi_inv", start, end);
+        };
+
+        /*
+         * As for b_transport, the SystemC thread must stay free while the remote handles it: it may call
+         * us back before answering.
+         */
+        if (std::this_thread::get_id() == sc_tid && sc_core::sc_get_status() >= sc_core::sc_status::SC_RUNNING &&
+            (sc_core::sc_get_curr_process_kind() == sc_core::sc_curr_proc_kind::SC_THREAD_PROC_ ||
+             sc_core::sc_get_curr_process_kind() == sc_core::sc_curr_proc_kind::SC_CTHREAD_PROC_)) {
+            std::atomic_bool done{ false };
+            btspt_waiter->start();
+
+            std::unique_lock<std::mutex> ul(btspt_waiter->rpc_execed_mut);
+            btspt_waiter->enqueue_notifier([&]() {
+                call_remote();
+                done = true;
+                btspt_waiter->dmi_inv_done_event.async_notify();
+            });
+            btspt_waiter->is_rpc_execed.notify_one();
+            ul.unlock();
+            /* The event is shared by all the invalidations in flight */
+            while (!done) {
+                sc_core::wait(btspt_waiter->dmi_inv_done_event);
+            }
+        } else {
+            call_remote();
+        }
     }
     void invalidate_direct_mem_ptr_rpc(sc_dt::uint64 start, sc_dt::uint64 end)
     {
         SCP_DEBUG(()) << " " << name() << " invalidate_direct_mem_ptr "
                       << " start address 0x" << std::hex << start << " end address 0x" << std::hex << end;
-#ifdef DMICACHE
-        cache_clean(start, end);
-#endif
+        {
+            std::lock_guard<std::mutex> lg(m_dmi_cache_mut);
+            cache_clean(start, end);
+        }
         for (int i = 0; i < target_sockets.size(); i++) {
             target_sockets[i]->invalidate_direct_mem_ptr(start, end);
         }
     }
 
+    void signal_rpc(int i, bool v)
+    {
+        if (sc_core::sc_get_status() < sc_core::sc_status::SC_START_OF_SIMULATION) {
+            std::lock_guard<std::mutex> lg(sig_queue_mut);
+            sig_queue.push(std::make_pair(i, v));
+            return;
+        }
+        m_sc.run_on_sysc([this, i, v] { initiator_signal_sockets[i]->write(v); },
+                         (sc_core::sc_get_status() < sc_core::sc_status::SC_RUNNING ? false : true));
+    }
+
     /**
      * find if the fully qualified parameter name belongs to a set of strings
      */
     bool is_self_param(const std::string& parent, const std::string& parname, const std::string& value)
     {
         std::vector<std::string> match_words = {
-            "args", "moduletype", "initiator_socket", "target_socket", "initiator_signal_socket", "target_signal_socket"
+            "args",          "moduletype", "initiator_socket", "target_socket", "initiator_signal_socket",
+            "target_signal_socket", "posted_writes"
         };
         return (std::find_if(match_words.begin(), match_words.end(), [parent, parname, value](std::string entry) {
                     std::string search_str = parent + "." + entry;
@@ -864,6 +1448,15 @@ private:
     }
 
 public:
+    /** Number of calls (waiting for a reply) sent over the shared memory channel so far */
+    uint64_t get_shm_calls() const { return m_shm_calls.load(std::memory_order_relaxed); }
+
+    /** Number of one way messages (posted writes, signals) sent over the shared memory channel so far */
+    uint64_t get_shm_posts() const { return m_shm_posts.load(std::memory_order_relaxed); }
+
+    /** Number of transactions served locally from the DMI cache so far */
+    uint64_t get_dmi_cache_hits() const { return m_dmi_cache_hits.load(std::memory_order_relaxed); }
+
     PassRPC(const sc_core::sc_module_name& nm, bool is_local = false)
         : sc_core::sc_module(nm)
         , m_broker(cci::cci_get_broker())
@@ -884,6 +1477,15 @@ public:
         , p_tlm_target_ports_num("tlm_target_ports_num", 0, "number of tlm target ports")
         , p_initiator_signals_num("initiator_signals_num", 0, "number of initiator signals")
         , p_target_signals_num("target_signals_num", 0, "number of target signals")
+        , p_shmem_transport("shmem_transport", false,
+                            "Carry transactions and signals over shared memory rather than rpc when possible "
+                            "(both sides must enable it, they must trust each other)")
+        , p_dmi_cache("dmi_cache", false,
+                      "Cache the DMI regions of the remote and serve b_transport from them (needs shmem_transport)")
+        , p_max_posted_writes("max_posted_writes", 64,
+                              "Posted writes in flight per port before waiting for their acknowledgements")
+        , p_shmem_staging_size("shmem_staging_size", 1024 * 1024,
+                               "Largest transaction data carried over shared memory, larger ones go over rpc")
         , cancel_waiting(false)
     {
         SigHandler::get().add_sig_handler(SIGINT, SigHandler::Handler_CB::PASS);
@@ -984,15 +1586,19 @@ public:
                 return;
             });
 
-            server->bind("signal", [&](int i, bool v) {
-                if (sc_core::sc_get_status() < sc_core::sc_status::SC_START_OF_SIMULATION) {
-                    std::lock_guard<std::mutex> lg(sig_queue_mut);
-                    sig_queue.push(std::make_pair(i, v));
-                    return;
+            server->bind("signal", [&](int i, bool v) { PassRPC::signal_rpc(i, v); });
+
+            server->bind("shm_chan", [&](std::string shm_name) {
+                if (!p_shmem_transport) return false;
+                RpcShmemChannel* shm = new RpcShmemChannel(shm_name, false);
+                if (!shm->is_open()) {
+                    delete shm;
+                    return false;
                 }
-                m_sc.run_on_sysc([&] { initiator_signal_sockets[i]->write(v); },
-                                 (sc_core::sc_get_status() < sc_core::sc_status::SC_RUNNING ? false : true));
-                return;
+                shm->serve([this, shm](shm_msg& req, shm_msg* rep) { shm_serve(shm, req, rep); });
+                SCP_INFO(()) << "Using shared memory transport " << shm_name;
+                m_shm = shm;
+                return true;
             });
 
             server->bind("sock_pair", [&](int sock_fd0, int sock_fd1) {
@@ -1004,18 +1610,27 @@ public:
                 return;
             });
 
-            // m_qk = tlm_quantumkeeper_factory(p_sync_policy);
-            // m_qk->reset();
+            if (p_sync_policy.get_value() == "multithread-distributed") {
+#ifdef SC_HAS_STAGE_CALLBACKS
+                m_qk = tlm_quantumkeeper_factory(p_sync_policy);
+#else
+                SCP_WARN(()) << name() << " multithread-distributed needs SystemC 3.0, "
+                             << "the remote time is not synchronised";
+#endif
+            }
             server->async_run(1);
 
             if (p_cport) {
                 SCP_INFO(()) << "Connecting client on port " << p_cport;
                 if (!client) client = new rpc::client("localhost", p_cport);
                 set_cci_db(do_rpc_as<str_pairs>(do_rpc_call("reg", (int)p_sport)));
+                if (p_shmem_transport) open_shmem_channel();
             }
         }
 
         btspt_waiter = std::make_unique<trans_waiter>("btspt_waiter", p_tlm_target_ports_num.get_value());
+        m_posted.resize(p_tlm_target_ports_num.get_value());
+        read_posted_ranges();
 
         initiator_sockets.init(p_tlm_initiator_ports_num.get_value(), [this](const char* n, int i) {
             return new initiator_socket_spying(n, [&](std::string s) -> void { remote_register_boundto(s); });
@@ -1043,6 +1658,11 @@ public:
                     m_container->fw_handle_signal(i, value);
                     return;
                 }
+                RpcShmemChannel* shm = m_shm;
+                if (shm) {
+                    do_shm_post(shm, SHM_SIGNAL, i, [&](shm_msg& m) { m.body[0] = value; });
+                    return;
+                }
                 do_rpc_async_call("signal", i, value);
             });
         }
@@ -1122,6 +1742,8 @@ public:
             std::lock_guard<std::mutex> scs_lg(sc_status_mut);
             is_sc_status_set.notify_one();
         }
+        if (m_qk) m_qk->stop();
+        if (RpcShmemChannel* shm = m_shm) shm->stop();
         btspt_waiter->stop();
         if (server) {
             server->close_sessions();
@@ -1159,8 +1781,27 @@ public:
     void start_of_simulation() override
     {
         if (is_local_mode()) return;
+#ifdef SC_HAS_STAGE_CALLBACKS
+        if (m_qk) {
+            /* Before the status exchange, so both sides publish their time once the simulation runs */
+            if (RpcShmemChannel* shm = m_shm) {
+                std::dynamic_pointer_cast<tlm_quantumkeeper_multi_distributed>(m_qk)->attach(shm);
+                m_qk->start();
+            } else {
+                SCP_WARN(()) << name() << " multithread-distributed needs the shared memory transport, "
+                             << "the remote time is not synchronised";
+            }
+        }
+#endif
         send_status();
         handle_before_sim_start_signals();
+        if (p_dmi_cache) {
+            if (m_shm) {
+                m_dmi_cache_on = true;
+            } else {
+                SCP_WARN(()) << name() << " dmi_cache needs the shared memory transport, it is disabled";
+            }
+        }
         // m_qk->start();
     }
 
@@ -1172,9 +1813,7 @@ public:
         // m_qk->stop();
         SCP_DEBUG(()) << "EXIT " << name();
         stop();
-#ifdef DMICACHE
-        m_dmi_cache.clear();
-#endif
+        delete m_shm.exchange(nullptr);
     }
 
     void end_of_simulation() override
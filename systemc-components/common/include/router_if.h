@@ -16,6 +16,7 @@
 #include <tlm_utils/multi_passthrough_target_socket.h>
 #include <tlm_sockets_buswidth.h>
 #include <string>
+#include <vector>
 
 namespace gs {
 template <unsigned int BUSWIDTH = DEFAULT_TLM_BUSWIDTH>
@@ -54,6 +55,7 @@ public:
         bool use_offset;
         bool is_callback;
         bool chained;
+        bool thread_safe;
         std::string shortname;
     };
 
@@ -65,6 +67,29 @@ public:
 
     virtual ~router_if() = default;
 
+    /**
+     * @brief Return the decoded address map of the router (one entry per
+     * target address range). Ranges are expressed in the router's own address
+     * space. Targets without a static address (e.g. dynamic targets) are not
+     * listed.
+     */
+    virtual std::vector<target_info> get_address_map()
+    {
+        lazy_initialize();
+        std::vector<target_info> map;
+        for (auto& ti : bound_targets) {
+            if (ti.size) map.push_back(ti);
+        }
+        return map;
+    }
+
+    /**
+     * @brief Whether the initiator socket implementing the backward interface
+     * `bw` is bound to the target socket of this router. Only valid once
+     * elaboration is over.
+     */
+    virtual bool is_initiator_bound(const tlm::tlm_bw_transport_if<>* bw) { return false; }
+
 protected:
     std::string parent(std::string name) { return name.substr(0, name.find_last_of('.')); }
 
@@ -0,0 +1,514 @@
+/*
+ * Copyright (c) 2024 Qualcomm Innovation Center, Inc. All Rights Reserved.
+ *
+ * SPDX-License-Identifier: BSD-3-Clause
+ */
+
+#ifndef _GREENSOCS_BASE_COMPONENTS_RPC_SHMEM_CHANNEL_H
+#define _GREENSOCS_BASE_COMPONENTS_RPC_SHMEM_CHANNEL_H
+
+#include <atomic>
+#include <chrono>
+#include <climits>
+#include <condition_variable>
+#include <cstdint>
+#include <functional>
+#include <mutex>
+#include <new>
+#include <string>
+#include <thread>
+
+#include <cerrno>
+#include <cstring>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#if defined(__linux__)
+#include <ctime>
+#include <linux/futex.h>
+#include <sys/syscall.h>
+#endif
+
+#include <scp/report.h>
+
+namespace gs {
+
+/**
+ * @brief Request/reply channel between two processes over shared memory.
+ *
+ * The segment holds one single producer, single consumer ring of requests per direction and, per
+ * direction, a set of reply slots. A request which expects an answer carries the index of a slot of
+ * the caller, in which the other side writes the reply. Both sides serve the requests of the other
+ * one from their own thread (see serve()). Sleeping consumers and callers are woken with futexes in
+ * the shared memory (doorbells); other hosts poll.
+ *
+ * The side creating the segment is side 0, the one joining it side 1; the name is unlinked once
+ * joined. Messages are fixed size, their body layout is up to the user.
+ *
+ * Each reply slot may come with a staging area in the segment, see staging(), for data too large for
+ * a message: only the message then goes through the ring, and the other side works on the data in
+ * place.
+ *
+ * Each side also publishes a generation counter and a time stamp, which the other side can read at
+ * any time without waiting for a message (e.g. to learn that state it caches has been invalidated,
+ * or how far the other simulation went).
+ */
+class RpcShmemChannel
+{
+    SCP_LOGGER((), "RpcShmemChannel");
+
+public:
+    static constexpr uint32_t RING_SIZE = 32; // requests in flight per direction
+    static constexpr uint32_t NR_SLOTS = 16;  // replies in flight per direction
+    static constexpr size_t MSG_BODY_SIZE = 4096 + 256;
+
+    struct msg {
+        uint32_t op;
+        int32_t id;
+        int32_t slot;  // reply slot of the caller, -1 for one way messages
+        uint32_t side; // side of the caller
+        uint8_t body[MSG_BODY_SIZE];
+    };
+
+private:
+    static_assert(ATOMIC_INT_LOCK_FREE == 2 && ATOMIC_LLONG_LOCK_FREE == 2, "shared memory atomics must be lock free");
+
+    /* Completion checks made by a caller before sleeping on its reply slot */
+    static constexpr int REPLY_SPIN_COUNT = 2000;
+    /* Sleeps are bounded so that closing the channel is always noticed */
+    static constexpr int WAIT_TIMEOUT_MS = 100;
+
+    enum slot_state : uint32_t { IDLE, PENDING, SLEEPING, DONE };
+
+    struct ring {
+        alignas(64) std::atomic<uint32_t> head;
+        alignas(64) std::atomic<uint32_t> tail; // futex word for drain()
+        std::atomic<uint32_t> draining;         // producers waiting in drain() or for room
+        alignas(64) std::atomic<uint32_t> bell; // futex word, bumped by the producer
+        std::atomic<uint32_t> sleeping;         // the consumer is (about to be) asleep on bell
+        msg msgs[RING_SIZE];
+    };
+
+    struct slot {
+        alignas(64) std::atomic<uint32_t> state; // futex word
+        msg reply;
+    };
+
+    struct layout {
+        uint32_t magic;
+        uint64_t staging_size; // per reply slot, the staging areas follow the layout
+        std::atomic<uint32_t> closed;
+        std::atomic<uint32_t> generations[2]; // generations[s] is published by side s
+        std::atomic<uint64_t> times[2];
+        std::atomic<uint32_t> time_seqs[2];    // futex words, bumped with times
+        std::atomic<uint32_t> time_waiting[2]; // time_waiting[s]: side s sleeps in wait_peer_time()
+        ring rings[2];             // rings[s] carries the requests of side s
+        slot slots[2][NR_SLOTS];   // slots[s] carries the replies to side s
+    };
+
+    static constexpr uint32_t MAGIC = 0x47535243; // "GSRC"
+
+    std::string m_name;
+    layout* m_layout = nullptr;
+    size_t m_size = 0;
+    uint8_t* m_staging = nullptr;
+    size_t m_staging_size = 0;
+    int m_side;
+
+    std::mutex m_send_mutex;
+    std::mutex m_slot_mutex;
+    std::condition_variable m_slot_cv;
+    uint32_t m_free_slots = (NR_SLOTS == 32) ? ~0u : ((1u << NR_SLOTS) - 1);
+
+    std::atomic<bool> m_stop{ false };
+    std::thread m_server;
+
+    static inline void cpu_relax()
+    {
+#if defined(__x86_64__) || defined(__i386__)
+        __builtin_ia32_pause();
+#elif defined(__aarch64__)
+        asm volatile("yield" ::: "memory");
+#endif
+    }
+
+    /* Sleep while *word == val, at most WAIT_TIMEOUT_MS */
+    static void futex_wait(std::atomic<uint32_t>* word, uint32_t val)
+    {
+#if defined(__linux__)
+        struct timespec ts;
+        ts.tv_sec = 0;
+        ts.tv_nsec = WAIT_TIMEOUT_MS * 1000000L;
+        syscall(SYS_futex, reinterpret_cast<uint32_t*>(word), FUTEX_WAIT, val, &ts, nullptr, 0);
+#else
+        if (word->load() == val) {
+            std::this_thread::sleep_for(std::chrono::microseconds(50));
+        }
+#endif
+    }
+
+    static void futex_wake(std::atomic<uint32_t>* word)
+    {
+#if defined(__linux__)
+        syscall(SYS_futex, reinterpret_cast<uint32_t*>(word), FUTEX_WAKE, INT_MAX, nullptr, nullptr, 0);
+#endif
+    }
+
+    bool closed() const { return m_stop || m_layout->closed.load(); }
+
+    static size_t staging_offset() { return (sizeof(layout) + 4095) & ~size_t(4095); }
+
+    int acquire_slot()
+    {
+        std::unique_lock<std::mutex> lock(m_slot_mutex);
+        m_slot_cv.wait(lock, [this]() { return m_free_slots != 0 || closed(); });
+        if (closed()) return -1;
+        int s = __builtin_ctz(m_free_slots);
+        m_free_slots &= ~(1u << s);
+        return s;
+    }
+
+    void release_slot(int s)
+    {
+        {
+            std::lock_guard<std::mutex> lock(m_slot_mutex);
+            m_free_slots |= (1u << s);
+        }
+        m_slot_cv.notify_one();
+    }
+
+    template <typename Fill>
+    bool push(uint32_t op, int id, int32_t reply_slot, Fill& fill)
+    {
+        std::lock_guard<std::mutex> lock(m_send_mutex);
+        ring& r = m_layout->rings[m_side];
+
+        uint32_t head = r.head.load(std::memory_order_relaxed);
+        if (head - r.tail.load(std::memory_order_acquire) == RING_SIZE) {
+            /* The other side is busy, sleep until it consumes a request, as in drain() */
+            r.draining.fetch_add(1);
+            for (;;) {
+                uint32_t tail = r.tail.load(std::memory_order_acquire);
+                if (head - tail != RING_SIZE || closed()) break;
+                futex_wait(&r.tail, tail);
+            }
+            r.draining.fetch_sub(1);
+            if (closed()) return false;
+        }
+
+        msg& m = r.msgs[head % RING_SIZE];
+        m.op = op;
+        m.id = id;
+        m.slot = reply_slot;
+        m.side = m_side;
+        fill(m);
+        r.head.store(head + 1, std::memory_order_release);
+
+        r.bell.fetch_add(1);
+        if (r.sleeping.load()) {
+            futex_wake(&r.bell);
+        }
+        return true;
+    }
+
+    bool wait_reply(slot& s)
+    {
+        for (int i = 0; i < REPLY_SPIN_COUNT; i++) {
+            if (s.state.load(std::memory_order_acquire) == DONE) return true;
+            cpu_relax();
+        }
+        uint32_t expected = PENDING;
+        if (!s.state.compare_exchange_strong(expected, SLEEPING)) {
+            return true; // DONE meanwhile
+        }
+        while (s.state.load(std::memory_order_acquire) == SLEEPING) {
+            if (closed()) return false;
+            futex_wait(&s.state, SLEEPING);
+        }
+        return true;
+    }
+
+    template <typename Handler>
+    void server_loop(Handler handler)
+    {
+        ring& r = m_layout->rings[1 - m_side];
+
+        while (!closed()) {
+            uint32_t tail = r.tail.load(std::memory_order_relaxed);
+            if (r.head.load(std::memory_order_acquire) == tail) {
+                r.sleeping.store(1);
+                uint32_t bell = r.bell.load();
+                if (r.head.load() == tail && !closed()) {
+                    futex_wait(&r.bell, bell);
+                }
+                r.sleeping.store(0);
+                continue;
+            }
+
+            msg& m = r.msgs[tail % RING_SIZE];
+            /* Written by the other process, only trusted once checked */
+            int32_t reply_slot = m.slot;
+            if (reply_slot < -1 || reply_slot >= int32_t(NR_SLOTS)) {
+                SCP_WARN(())("{}: invalid reply slot {}, closing the channel", m_name, reply_slot);
+                stop();
+                break;
+            }
+            m.side = 1 - m_side;
+            m.slot = reply_slot;
+            if (reply_slot >= 0) {
+                slot& s = m_layout->slots[1 - m_side][reply_slot];
+                s.reply.slot = reply_slot; // so that staging() finds the area of the reply
+                s.reply.side = 1 - m_side;
+                handler(m, &s.reply);
+                if (s.state.exchange(DONE) == SLEEPING) {
+                    futex_wake(&s.state);
+                }
+            } else {
+                handler(m, nullptr);
+            }
+            /*
+             * Sequentially consistent, as the increment of draining by the producers: the store must not be
+             * reordered after the load, or a producer that just started waiting would not be woken up.
+             */
+            r.tail.store(tail + 1);
+            if (r.draining.load()) {
+                futex_wake(&r.tail);
+            }
+        }
+    }
+
+public:
+    /**
+     * Create (side 0) or join (side 1) the channel in the shared memory segment `name`, see is_open().
+     * The creator sets the size of the staging area of each reply slot (rounded up to a page, none if
+     * zero); the segment is sparse, only the pages used take memory.
+     */
+    RpcShmemChannel(const std::string& name, bool create, size_t staging_size = 0)
+        : m_name(name), m_side(create ? 0 : 1)
+    {
+        int fd = shm_open(name.c_str(), create ? (O_CREAT | O_EXCL | O_RDWR) : O_RDWR, S_IRUSR | S_IWUSR);
+        if (fd == -1) {
+            SCP_WARN(())("can't shm_open {}: {}", name, std::strerror(errno));
+            return;
+        }
+        if (create) {
+            m_staging_size = (staging_size + 4095) & ~size_t(4095);
+            m_size = staging_offset() + 2 * NR_SLOTS * m_staging_size;
+            if (ftruncate(fd, m_size) == -1) {
+                SCP_WARN(())("can't size {}: {}", name, std::strerror(errno));
+                close(fd);
+                shm_unlink(name.c_str());
+                return;
+            }
+        } else {
+            struct stat st;
+            if (fstat(fd, &st) == -1 || size_t(st.st_size) < staging_offset()) {
+                SCP_WARN(())("shared memory channel {} is not initialised", name);
+                close(fd);
+                shm_unlink(name.c_str());
+                return;
+            }
+            m_size = st.st_size;
+        }
+        void* base = mmap(nullptr, m_size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+        close(fd);
+        if (base == MAP_FAILED) {
+            SCP_WARN(())("can't mmap {}: {}", name, std::strerror(errno));
+            if (create) shm_unlink(name.c_str());
+            return;
+        }
+
+        if (create) {
+            m_layout = new (base) layout;
+            m_layout->staging_size = m_staging_size;
+            for (int side = 0; side < 2; side++) {
+                ring& r = m_layout->rings[side];
+                r.head.store(0);
+                r.tail.store(0);
+                r.draining.store(0);
+                r.bell.store(0);
+                r.sleeping.store(0);
+                for (auto& s : m_layout->slots[side]) {
+                    s.state.store(IDLE);
+                }
+            }
+            m_layout->closed.store(0);
+            for (int side = 0; side < 2; side++) {
+                m_layout->generations[side].store(0);
+                m_layout->times[side].store(0);
+                m_layout->time_seqs[side].store(0);
+                m_layout->time_waiting[side].store(0);
+            }
+            m_layout->magic = MAGIC;
+        } else {
+            shm_unlink(name.c_str());
+            m_layout = static_cast<layout*>(base);
+            if (m_layout->magic != MAGIC ||
+                m_size != staging_offset() + 2 * NR_SLOTS * size_t(m_layout->staging_size)) {
+                SCP_WARN(())("shared memory channel {} is not initialised", name);
+                munmap(base, m_size);
+                m_layout = nullptr;
+                return;
+            }
+            m_staging_size = m_layout->staging_size;
+        }
+        m_staging = static_cast<uint8_t*>(base) + staging_offset();
+    }
+
+    RpcShmemChannel(const RpcShmemChannel&) = delete;
+    RpcShmemChannel& operator=(const RpcShmemChannel&) = delete;
+
+    ~RpcShmemChannel()
+    {
+        if (!m_layout) return;
+        stop();
+        if (m_server.joinable()) m_server.join();
+        munmap(m_layout, m_size);
+    }
+
+    bool is_open() const { return m_layout != nullptr; }
+
+    /** Remove the name of a segment which the other side did not join. */
+    void unlink() { shm_unlink(m_name.c_str()); }
+
+    const char* name() const { return "RpcShmemChannel"; }
+
+    const std::string& shm_name() const { return m_name; }
+
+    /**
+     * Serve the requests of the other side on a new thread. `handler(msg& request, msg* reply)` is
+     * given a null reply for one way messages; it may use the request body as scratch space.
+     */
+    template <typename Handler>
+    void serve(Handler handler)
+    {
+        m_server = std::thread([this, handler]() { server_loop(handler); });
+    }
+
+    /**
+     * Send a request, filled in place by `fill(msg&)`, and wait for the reply, which is passed to
+     * `reply(msg&)`. Returns false if the channel was closed. Safe from any thread.
+     */
+    template <typename Fill, typename Reply>
+    bool call(uint32_t op, int id, Fill&& fill, Reply&& reply)
+    {
+        int s = acquire_slot();
+        if (s < 0) return false;
+
+        slot& rs = m_layout->slots[m_side][s];
+        rs.state.store(PENDING);
+        if (!push(op, id, s, fill) || !wait_reply(rs)) {
+            return false; // the slot is not reused, the other side may still write it
+        }
+        reply(rs.reply);
+        rs.state.store(IDLE);
+        release_slot(s);
+        return true;
+    }
+
+    /** Size of the staging area of each reply slot, 0 if there is none */
+    size_t staging_size() const { return m_staging_size; }
+
+    /**
+     * Staging area of the reply slot of `m`: a request being filled by call(), a request being served,
+     * or a reply. Both sides of a call see the same area, until the reply has been handled. Null for
+     * one way messages or without staging areas.
+     */
+    uint8_t* staging(const msg& m) const
+    {
+        int32_t slot = m.slot;
+        uint32_t side = m.side;
+        if (!m_staging_size || slot < 0 || slot >= int32_t(NR_SLOTS) || side > 1) return nullptr;
+        return m_staging + (size_t(side) * NR_SLOTS + slot) * m_staging_size;
+    }
+
+    /** Requests which can be sent right now without waiting for room in the ring */
+    uint32_t send_room() const
+    {
+        const ring& r = m_layout->rings[m_side];
+        return RING_SIZE - (r.head.load() - r.tail.load());
+    }
+
+    /** Send a one way message. Returns false if the channel was closed. */
+    template <typename Fill>
+    bool post(uint32_t op, int id, Fill&& fill)
+    {
+        return push(op, id, -1, fill);
+    }
+
+    /**
+     * Wait until the other side has handled every request sent so far (including one way messages).
+     * Returns false if the channel was closed.
+     */
+    bool drain()
+    {
+        ring& r = m_layout->rings[m_side];
+        uint32_t head = r.head.load();
+        bool ok = true;
+        r.draining.fetch_add(1);
+        for (;;) {
+            uint32_t tail = r.tail.load(std::memory_order_acquire);
+            if (int32_t(tail - head) >= 0) break;
+            if (closed()) {
+                ok = false;
+                break;
+            }
+            futex_wait(&r.tail, tail);
+        }
+        r.draining.fetch_sub(1);
+        return ok;
+    }
+
+    /** Advance the generation counter of this side, see peer_generation(). Returns the new value. */
+    uint32_t bump_generation() { return m_layout->generations[m_side].fetch_add(1) + 1; }
+
+    /** Generation counter of the other side */
+    uint32_t peer_generation() const { return m_layout->generations[1 - m_side].load(); }
+
+    /** Publish the time stamp of this side, waking the other side if it waits for it */
+    void publish_time(uint64_t t)
+    {
+        m_layout->times[m_side].store(t);
+        m_layout->time_seqs[m_side].fetch_add(1);
+        if (m_layout->time_waiting[1 - m_side].load()) {
+            futex_wake(&m_layout->time_seqs[m_side]);
+        }
+    }
+
+    /** Last time stamp published by the other side */
+    uint64_t peer_time() const { return m_layout->times[1 - m_side].load(); }
+
+    /** Wait (at most WAIT_TIMEOUT_MS) for the other side to publish a time stamp other than `seen` */
+    void wait_peer_time(uint64_t seen)
+    {
+        std::atomic<uint32_t>* seq = &m_layout->time_seqs[1 - m_side];
+        m_layout->time_waiting[m_side].store(1);
+        uint32_t s = seq->load();
+        if (peer_time() == seen && !closed()) {
+            futex_wait(seq, s);
+        }
+        m_layout->time_waiting[m_side].store(0);
+    }
+
+    /** Close the channel, on both sides. Waiting callers return false. */
+    void stop()
+    {
+        if (!m_layout || m_stop.exchange(true)) return;
+        m_layout->closed.store(1);
+        for (int side = 0; side < 2; side++) {
+            futex_wake(&m_layout->rings[side].bell);
+            futex_wake(&m_layout->rings[side].tail);
+            futex_wake(&m_layout->time_seqs[side]);
+            for (auto& s : m_layout->slots[side]) {
+                futex_wake(&s.state);
+            }
+        }
+        m_slot_cv.notify_all();
+    }
+};
+
+} // namespace gs
+
+#endif // _GREENSOCS_BASE_COMPONENTS_RPC_SHMEM_CHANNEL_H
@@ -8,106 +8,373 @@
 #ifndef RUNONSYSTEMC_H
 #define RUNONSYSTEMC_H
 
-#include <thread>
-#include <mutex>
+#include <atomic>
 #include <condition_variable>
-#include <queue>
-#include <future>
+#include <cstddef>
+#include <cstdint>
+#include <exception>
+#include <memory>
+#include <mutex>
+#include <new>
+#include <thread>
+#include <type_traits>
+#include <unordered_set>
+#include <utility>
 
 #include <async_event.h>
+#include <sync_profile.h>
+#include <trace_exporter.h>
 #include <uutils.h>
 #include <module_factory_registery.h>
 
 namespace gs {
+/*
+ * Jobs are posted from any thread to a lock-free multi-producer single-consumer
+ * queue, drained by the jobs_handler SystemC thread. Each job lives in a slot
+ * taken from a pool that only ever grows, so that posting a job (and waiting
+ * for it) does not allocate once the pool is warm. Past the maximum size of
+ * the pool, slots are allocated (and freed) one by one.
+ */
 class runonsysc : public sc_core::sc_module
 {
+    SCP_LOGGER();
+
 protected:
-    class AsyncJob
+    /* Intrusive link of the job queue */
+    struct node {
+        std::atomic<node*> next{ nullptr };
+    };
+
+    class job_slot : public node
     {
     public:
-        using Ptr = std::shared_ptr<AsyncJob>;
+        enum state : int { FREE, PENDING, RUNNING, DONE, CANCELLED };
+
+        /* Captures up to this size are stored in the slot, bigger ones on the heap */
+        static constexpr size_t INLINE_SIZE = 64;
 
     private:
-        std::packaged_task<void()> m_task;
+        typename std::aligned_storage<INLINE_SIZE, alignof(std::max_align_t)>::type m_storage;
+        void (*m_call)(void*) = nullptr;
+        void (*m_destroy)(void*) = nullptr;
+
+        std::atomic<int> m_state{ FREE };
+        std::exception_ptr m_exception;
+
+        /* Completion wait: spin first, then sleep on the condition variable */
+        std::mutex m_mutex;
+        std::condition_variable m_cv;
+        std::atomic<bool> m_sleeping{ false };
+
+        template <typename Fn, typename F>
+        void set_job(F&& job, std::true_type /* inline */)
+        {
+            new (&m_storage) Fn(std::forward<F>(job));
+            m_call = [](void* p) { (*static_cast<Fn*>(p))(); };
+            m_destroy = [](void* p) { static_cast<Fn*>(p)->~Fn(); };
+        }
+
+        template <typename Fn, typename F>
+        void set_job(F&& job, std::false_type /* inline */)
+        {
+            new (&m_storage) Fn*(new Fn(std::forward<F>(job)));
+            m_call = [](void* p) { (**static_cast<Fn**>(p))(); };
+            m_destroy = [](void* p) { delete *static_cast<Fn**>(p); };
+        }
 
-        bool m_cancelled = false;
+        void signal()
+        {
+            if (m_sleeping.load()) {
+                std::lock_guard<std::mutex> lock(m_mutex);
+                m_cv.notify_one();
+            }
+        }
 
-        void run_job() { m_task(); }
+        bool finished() const { return m_state.load() >= DONE; }
 
     public:
-        AsyncJob(std::function<void()>&& job): m_task(job) {}
+        uint32_t index = 0;
+        std::atomic<uint32_t> next_free{ 0 };
+        std::atomic<int> refs{ 0 };
 
-        AsyncJob(std::function<void()>& job): m_task(job) {}
+        template <typename F>
+        void prepare(F&& job, int nrefs)
+        {
+            using Fn = typename std::decay<F>::type;
+            using fits = std::integral_constant<bool, sizeof(Fn) <= INLINE_SIZE &&
+                                                          alignof(Fn) <= alignof(std::max_align_t)>;
+            set_job<Fn>(std::forward<F>(job), fits());
+            m_exception = nullptr;
+            next.store(nullptr, std::memory_order_relaxed);
+            refs.store(nrefs, std::memory_order_relaxed);
+            m_state.store(PENDING, std::memory_order_relaxed);
+        }
 
-        AsyncJob() = delete;
-        AsyncJob(const AsyncJob&) = delete;
+        /* Called by the jobs handler only */
+        bool start()
+        {
+            int expected = PENDING;
+            return m_state.compare_exchange_strong(expected, RUNNING);
+        }
 
-        void operator()() { run_job(); }
+        void run()
+        {
+            try {
+                m_call(&m_storage);
+            } catch (...) {
+                m_exception = std::current_exception();
+            }
+        }
+
+        void destroy_job()
+        {
+            if (m_destroy) {
+                m_destroy(&m_storage);
+                m_call = nullptr;
+                m_destroy = nullptr;
+            }
+        }
+
+        void complete()
+        {
+            int expected = RUNNING;
+            if (m_state.compare_exchange_strong(expected, DONE)) {
+                signal();
+            }
+        }
 
         /**
          * @brief Cancel a job
          *
-         * @details Cancel a job by setting m_cancelled to true and by
-         * resetting the task. Any waiter will then be unblocked immediately.
+         * @details A pending job will not be run, and the waiter of a
+         * pending or running job is unblocked immediately.
          */
-        void cancel()
+        void cancel(bool running)
         {
-            m_cancelled = true;
-            m_task.reset();
+            int expected = PENDING;
+            if (m_state.compare_exchange_strong(expected, CANCELLED)) {
+                signal();
+                return;
+            }
+            expected = RUNNING;
+            if (running && m_state.compare_exchange_strong(expected, CANCELLED)) {
+                signal();
+            }
         }
 
         void wait()
         {
-            auto future = m_task.get_future();
-
-            future.wait();
-
-            if (!m_cancelled) {
-                future.get();
+            for (int i = 0; i < WAIT_SPIN_COUNT && !finished(); i++) {
+                cpu_relax();
+            }
+            if (!finished()) {
+                std::unique_lock<std::mutex> lock(m_mutex);
+                m_sleeping.store(true);
+                while (!finished()) {
+                    m_cv.wait(lock);
+                }
+                m_sleeping.store(false);
+            }
+            if (!is_cancelled() && m_exception) {
+                std::rethrow_exception(m_exception);
             }
         }
 
-        bool is_cancelled() const { return m_cancelled; }
+        bool is_cancelled() const { return m_state.load() == CANCELLED; }
+
+        void reset() { m_state.store(FREE, std::memory_order_relaxed); }
     };
 
+    /* Completion checks made by a waiting thread before sleeping */
+    static constexpr int WAIT_SPIN_COUNT = 200;
+
+    static constexpr uint32_t POOL_CHUNK_SIZE = 64;
+    static constexpr uint32_t POOL_MAX_CHUNKS = 1024;
+    /* Index of the slots allocated outside of the pool */
+    static constexpr uint32_t OVERFLOW_INDEX = UINT32_MAX;
+
+    static inline void cpu_relax()
+    {
+#if defined(__x86_64__) || defined(__i386__)
+        __builtin_ia32_pause();
+#elif defined(__aarch64__)
+        asm volatile("yield" ::: "memory");
+#endif
+    }
+
     std::thread::id m_thread_id;
 
-    /* Async job queue */
-    std::queue<AsyncJob::Ptr> m_async_jobs;
-    AsyncJob::Ptr m_running_job;
-    std::mutex m_async_jobs_mutex;
+    /* Slot pool: chunks are never released before destruction */
+    std::atomic<job_slot*> m_chunks[POOL_MAX_CHUNKS];
+    std::atomic<uint32_t> m_nb_chunks{ 0 };
+    std::mutex m_pool_mutex;
+    /* Free list head: ABA tag in the upper half, slot index + 1 in the lower half (0 when empty) */
+    std::atomic<uint64_t> m_free{ 0 };
+    /* Slots in use outside of the pool, protected by m_pool_mutex */
+    std::unordered_set<job_slot*> m_overflow;
+    bool m_overflow_reported = false;
+
+    /* MPSC job queue (Vyukov): producers exchange m_head, the jobs handler owns m_tail */
+    node m_stub;
+    std::atomic<node*> m_head;
+    node* m_tail;
 
     async_event m_jobs_handler_event;
 
-    // Process inside a thread incase the job calls wait
-    void jobs_handler()
+    job_slot& slot_at(uint32_t index)
+    {
+        return m_chunks[index / POOL_CHUNK_SIZE].load(std::memory_order_acquire)[index % POOL_CHUNK_SIZE];
+    }
+
+    void free_slot(job_slot* slot)
     {
-        std::unique_lock<std::mutex> lock(m_async_jobs_mutex);
+        uint64_t old = m_free.load();
+        uint64_t val;
+        do {
+            slot->next_free.store(uint32_t(old), std::memory_order_relaxed);
+            val = (((old >> 32) + 1) << 32) | (slot->index + 1);
+        } while (!m_free.compare_exchange_weak(old, val));
+    }
+
+    job_slot* pop_free_slot()
+    {
+        uint64_t old = m_free.load();
         for (;;) {
-            while (!m_async_jobs.empty()) {
-                m_running_job = m_async_jobs.front();
-                m_async_jobs.pop();
+            uint32_t top = uint32_t(old);
+            if (top == 0) {
+                return nullptr;
+            }
+            uint32_t next = slot_at(top - 1).next_free.load(std::memory_order_relaxed);
+            uint64_t val = (((old >> 32) + 1) << 32) | next;
+            if (m_free.compare_exchange_weak(old, val)) {
+                return &slot_at(top - 1);
+            }
+        }
+    }
+
+    job_slot* alloc_slot()
+    {
+        job_slot* slot = pop_free_slot();
+        while (!slot) {
+            std::lock_guard<std::mutex> lock(m_pool_mutex);
+            slot = pop_free_slot(); // another thread may have grown the pool meanwhile
+            if (slot) {
+                break;
+            }
+
+            uint32_t n = m_nb_chunks.load();
+            if (n == POOL_MAX_CHUNKS) {
+                if (!m_overflow_reported) {
+                    SCP_WARN(())("More than {} pending jobs, allocating them", POOL_MAX_CHUNKS * POOL_CHUNK_SIZE);
+                    m_overflow_reported = true;
+                }
+                slot = new job_slot;
+                slot->index = OVERFLOW_INDEX;
+                m_overflow.insert(slot);
+                break;
+            }
+            job_slot* chunk = new job_slot[POOL_CHUNK_SIZE];
+            for (uint32_t i = 0; i < POOL_CHUNK_SIZE; i++) {
+                chunk[i].index = n * POOL_CHUNK_SIZE + i;
+            }
+            m_chunks[n].store(chunk, std::memory_order_release);
+            m_nb_chunks.store(n + 1);
 
-                lock.unlock();
-                sc_core::sc_unsuspendable(); // a wait in the job will cause systemc time to advance
-                (*m_running_job)();
-                sc_core::sc_suspendable();
-                lock.lock();
+            for (uint32_t i = 1; i < POOL_CHUNK_SIZE; i++) {
+                free_slot(&chunk[i]);
+            }
+            slot = &chunk[0];
+        }
+        return slot;
+    }
+
+    /* Drop a reference on a slot, the last one returns it to the pool */
+    void release_slot(job_slot* slot)
+    {
+        if (slot->refs.fetch_sub(1) == 1) {
+            if (slot->index == OVERFLOW_INDEX) {
+                std::lock_guard<std::mutex> lock(m_pool_mutex);
+                m_overflow.erase(slot);
+                delete slot;
+                return;
+            }
+            slot->reset();
+            free_slot(slot);
+        }
+    }
+
+    void push(node* n)
+    {
+        n->next.store(nullptr, std::memory_order_relaxed);
+        node* prev = m_head.exchange(n);
+        prev->next.store(n, std::memory_order_release);
+    }
+
+    /*
+     * Consumer side, jobs handler only. May return nullptr while a producer
+     * is half way through push(). It notifies the handler once done.
+     */
+    job_slot* pop()
+    {
+        node* tail = m_tail;
+        node* next = tail->next.load(std::memory_order_acquire);
+        if (tail == &m_stub) {
+            if (!next) {
+                return nullptr;
+            }
+            m_tail = next;
+            tail = next;
+            next = next->next.load(std::memory_order_acquire);
+        }
+        if (next) {
+            m_tail = next;
+            return static_cast<job_slot*>(tail);
+        }
+        if (tail != m_head.load()) {
+            return nullptr;
+        }
+        push(&m_stub);
+        next = tail->next.load(std::memory_order_acquire);
+        if (next) {
+            m_tail = next;
+            return static_cast<job_slot*>(tail);
+        }
+        return nullptr;
+    }
 
-                m_running_job.reset();
+    // Process inside a thread incase the job calls wait
+    void jobs_handler()
+    {
+        for (;;) {
+            while (job_slot* job = pop()) {
+                if (job->start()) {
+                    sc_core::sc_unsuspendable(); // a wait in the job will cause systemc time to advance
+                    {
+                        TraceExporter::span trace("runonsysc", "job");
+                        job->run();
+                    }
+                    sc_core::sc_suspendable();
+                    job->destroy_job();
+                    job->complete();
+                } else {
+                    job->destroy_job(); // cancelled before it started
+                }
+                release_slot(job);
             }
 
-            lock.unlock();
             wait(m_jobs_handler_event);
-            lock.lock();
         }
     }
 
-    void cancel_pendings_locked()
+    void cancel_jobs(bool running)
     {
-        while (!m_async_jobs.empty()) {
-            m_async_jobs.front()->cancel();
-            m_async_jobs.pop();
+        uint32_t n = m_nb_chunks.load();
+        for (uint32_t i = 0; i < n * POOL_CHUNK_SIZE; i++) {
+            slot_at(i).cancel(running);
+        }
+        std::lock_guard<std::mutex> lock(m_pool_mutex);
+        for (job_slot* slot : m_overflow) {
+            slot->cancel(running);
         }
     }
 
@@ -115,25 +382,40 @@ public:
     runonsysc(const sc_core::sc_module_name& n = sc_core::sc_module_name("run-on-sysc"))
         : sc_module(n)
         , m_thread_id(std::this_thread::get_id())
+        , m_head(&m_stub)
+        , m_tail(&m_stub)
         , m_jobs_handler_event(false) // starve if no more jobs provided
     {
+        for (auto& chunk : m_chunks) {
+            chunk.store(nullptr, std::memory_order_relaxed);
+        }
         SC_HAS_PROCESS(runonsysc);
         SC_THREAD(jobs_handler);
         SigHandler::get().register_on_exit_cb([this]() { cancel_all(); });
     }
 
+    ~runonsysc()
+    {
+        /* Release the jobs left in the queue, they can no longer run */
+        while (job_slot* job = pop()) {
+            job->destroy_job();
+        }
+        for (job_slot* slot : m_overflow) {
+            delete slot;
+        }
+        uint32_t n = m_nb_chunks.load();
+        for (uint32_t i = 0; i < n; i++) {
+            delete[] m_chunks[i].load();
+        }
+    }
+
     /**
      * @brief Cancel all pending jobs
      *
      * @detail Cancel all the pending jobs. The callers will be unblocked
      *         if they are waiting for the job.
      */
-    void cancel_pendings()
-    {
-        std::lock_guard<std::mutex> lock(m_async_jobs_mutex);
-
-        cancel_pendings_locked();
-    }
+    void cancel_pendings() { cancel_jobs(false); }
 
     /**
      * @brief Cancel all pending and running jobs
@@ -144,21 +426,15 @@ public:
      *         behaviour is undefined. This method is meant to be called
      *         after simulation has ended.
      */
-    void cancel_all()
-    {
-        std::lock_guard<std::mutex> lock(m_async_jobs_mutex);
-
-        cancel_pendings_locked();
-
-        if (m_running_job) {
-            m_running_job->cancel();
-            m_running_job.reset();
-        }
-    }
+    void cancel_all() { cancel_jobs(true); }
 
     void end_of_simulation() { cancel_all(); }
 
-    void fork_on_systemc(std::function<void()> job_entry) { run_on_sysc(job_entry, false); }
+    template <typename F>
+    void fork_on_systemc(F&& job_entry)
+    {
+        run_on_sysc(std::forward<F>(job_entry), false);
+    }
 
     /**
      * @brief Run a job on the SystemC kernel thread
@@ -170,25 +446,36 @@ public:
      *         was false, false if it has been cancelled (see
      *         `RunOnSysC::cancel_all`).
      */
-    bool run_on_sysc(std::function<void()> job_entry, bool wait = true)
+    template <typename F>
+    bool run_on_sysc(F&& job_entry, bool wait = true)
     {
         if (is_on_sysc()) {
             job_entry();
             return true;
         } else {
-            AsyncJob::Ptr job(new AsyncJob(job_entry));
+            /* The handler holds one reference, the waiter (if any) the other */
+            job_slot* job = alloc_slot();
+            job->prepare(std::forward<F>(job_entry), wait ? 2 : 1);
 
-            {
-                std::lock_guard<std::mutex> lock(m_async_jobs_mutex);
-                m_async_jobs.push(job);
-            }
+            push(job);
 
             m_jobs_handler_event.async_notify();
 
             if (wait) {
                 /* Wait for job completion */
-                job->wait();
-                return !job->is_cancelled();
+                bool cancelled;
+                {
+                    sync_profile::scope prof_scope(sync_profile::SYSC_WAIT);
+                    try {
+                        job->wait();
+                    } catch (...) {
+                        release_slot(job);
+                        throw;
+                    }
+                    cancelled = job->is_cancelled();
+                }
+                release_slot(job);
+                return !cancelled;
             }
 
             return true;
@@ -0,0 +1,114 @@
+/*
+ * Copyright (c) 2024 Qualcomm Innovation Center, Inc. All Rights Reserved.
+ *
+ * SPDX-License-Identifier: BSD-3-Clause
+ */
+
+#ifndef SYNC_PROFILE_H
+#define SYNC_PROFILE_H
+
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+
+namespace gs {
+/**
+ * @brief Wall clock time breakdown of a simulation thread (typically a vCPU)
+ *
+ * The thread owning the profile attaches it with set_current(). From then on, code running on that
+ * thread marks the time spent in a given state with a scope object. The time not covered by any scope
+ * is accounted as RUNNING. Scopes nest, the outermost one wins: an I/O access waiting for SystemC is
+ * accounted as IO. Scopes created on a thread without a profile do nothing, so they can be placed in
+ * shared code paths (e.g. run_on_sysc).
+ *
+ * The accumulated values can be read from any thread.
+ */
+class sync_profile
+{
+public:
+    enum state {
+        RUNNING = 0, // executing (TCG/KVM) or anything not covered below
+        BUDGET_WAIT, // waiting for run budget in the quantum keeper
+        SYSC_WAIT,   // waiting for a job to be run by the SystemC thread
+        IDLE,        // nothing to execute (WFI, halted)
+        IO,          // I/O access round trip
+        NUM_STATES
+    };
+
+    static const char* state_name(state s)
+    {
+        static const char* names[NUM_STATES] = { "running", "budget_wait", "sysc_wait", "idle", "io" };
+        return names[s];
+    }
+
+    class scope
+    {
+        sync_profile* m_profile;
+        state m_prev;
+
+    public:
+        scope(state s): m_profile(current()), m_prev(RUNNING)
+        {
+            if (m_profile && m_profile->get_state() != RUNNING) m_profile = nullptr;
+            if (m_profile) m_prev = m_profile->switch_to(s);
+        }
+        ~scope()
+        {
+            if (m_profile) m_profile->switch_to(m_prev);
+        }
+        scope(const scope&) = delete;
+        scope& operator=(const scope&) = delete;
+    };
+
+    sync_profile()
+    {
+        for (auto& ns : m_ns) ns = 0;
+    }
+
+    /* Attach (or detach, with nullptr) a profile to the calling thread */
+    static void set_current(sync_profile* p)
+    {
+        if (p) {
+            p->m_state = RUNNING;
+            p->m_since = std::chrono::steady_clock::now();
+        }
+        current() = p;
+    }
+
+    static sync_profile*& current();
+
+    /* Owner thread only: account the time since the last switch, returns the previous state */
+    state switch_to(state s)
+    {
+        auto now = std::chrono::steady_clock::now();
+        auto ns = std::chrono::duration_cast<std::chrono::nanoseconds>(now - m_since).count();
+        m_ns[m_state].fetch_add(ns, std::memory_order_relaxed);
+        m_since = now;
+        state prev = m_state;
+        m_state = s;
+        return prev;
+    }
+
+    /* Owner thread only */
+    state get_state() const { return m_state; }
+
+    uint64_t get_ns(state s) const { return m_ns[s].load(std::memory_order_relaxed); }
+
+    /* sc_suspend_all/sc_unsuspend_all calls made on behalf of this thread */
+    void count_suspend() { m_suspends.fetch_add(1, std::memory_order_relaxed); }
+    void count_unsuspend() { m_unsuspends.fetch_add(1, std::memory_order_relaxed); }
+    uint64_t get_suspends() const { return m_suspends.load(std::memory_order_relaxed); }
+    uint64_t get_unsuspends() const { return m_unsuspends.load(std::memory_order_relaxed); }
+
+private:
+    std::atomic<uint64_t> m_ns[NUM_STATES];
+    std::atomic<uint64_t> m_suspends{ 0 };
+    std::atomic<uint64_t> m_unsuspends{ 0 };
+
+    /* Owner thread only */
+    state m_state = RUNNING;
+    std::chrono::steady_clock::time_point m_since;
+};
+} // namespace gs
+
+#endif // SYNC_PROFILE_H
@@ -0,0 +1,97 @@
+/*
+ * Copyright (c) 2024 Qualcomm Innovation Center, Inc. All Rights Reserved.
+ *
+ * SPDX-License-Identifier: BSD-3-Clause
+ */
+
+#ifndef _GREENSOCS_BASE_COMPONENTS_THREAD_PLACEMENT_H
+#define _GREENSOCS_BASE_COMPONENTS_THREAD_PLACEMENT_H
+
+#include <map>
+#include <mutex>
+#include <string>
+#include <vector>
+
+#include <cci_configuration>
+#include <systemc>
+
+#include <scp/report.h>
+
+namespace gs {
+
+/**
+ * @brief Singleton that applies host placement (CPU set, scheduling policy, nice value and thread
+ * name) to the threads created by the simulator.
+ *
+ * Threads are grouped in classes, each one configured from the global broker, e.g. in Lua:
+ *
+ *     thread_placement = {
+ *         systemc = { cpus = "0" },
+ *         vcpu    = { cpus = "2-7", nice = -5 },
+ *         io      = { cpus = "1", nice = 5 },
+ *     }
+ *
+ * Per class the following keys are recognised:
+ *   - cpus     : CPU list ("0,2,4-7"), empty means no affinity change.
+ *   - policy   : "other" (default), "batch", "idle", "fifo" or "rr".
+ *   - priority : static priority, only meaningful with "fifo" and "rr".
+ *   - nice     : nice value applied to the thread (SCHED_OTHER/BATCH).
+ *
+ * The configuration is read by init(), which must be called on the SystemC thread during
+ * elaboration; the module factory container does it when it is constructed. The "systemc" class is
+ * applied to that thread at the same time. apply() itself is safe to call from any thread, and
+ * leaves threads untouched until the configuration is loaded.
+ */
+class ThreadPlacement
+{
+    SCP_LOGGER((), "ThreadPlacement");
+
+public:
+    static constexpr const char* SYSTEMC = "systemc"; // SystemC kernel thread
+    static constexpr const char* VCPU = "vcpu";       // QEMU vCPU threads
+    static constexpr const char* SYNC = "sync";       // quantum keeper worker threads
+    static constexpr const char* TIMER = "timer";     // real time pacing threads
+    static constexpr const char* IO = "io";           // backend receive threads
+
+    static ThreadPlacement& get();
+
+    /** Load the configuration from the global broker, once. */
+    static void init();
+
+    ThreadPlacement(ThreadPlacement const&) = delete;
+    void operator=(ThreadPlacement const&) = delete;
+
+    /**
+     * Apply the placement of the class `cls` to the calling thread, and name it `thread_name`
+     * (truncated to the 15 characters supported by the host).
+     */
+    void apply(const std::string& cls, const std::string& thread_name);
+
+    bool is_configured(const std::string& cls) const;
+
+    const char* name() const { return "ThreadPlacement"; }
+
+private:
+    struct policy {
+        std::vector<int> cpus;
+        bool has_sched = false;
+        std::string sched = "other";
+        int priority = 0;
+        bool has_nice = false;
+        int nice = 0;
+    };
+
+    ThreadPlacement() = default;
+
+    void load(cci::cci_broker_handle broker, const std::string& cls);
+
+    static bool parse_cpus(const std::string& list, std::vector<int>& cpus);
+
+    std::map<std::string, policy> m_policies;
+    bool m_loaded = false;
+    mutable std::mutex m_mutex;
+};
+
+} // namespace gs
+
+#endif // _GREENSOCS_BASE_COMPONENTS_THREAD_PLACEMENT_H
@@ -0,0 +1,63 @@
+/*
+ * Copyright (c) 2024 Qualcomm Innovation Center, Inc. All Rights Reserved.
+ *
+ * SPDX-License-Identifier: BSD-3-Clause
+ */
+
+#ifndef _GREENSOCS_THREAD_SAFE_EXTENSION_H
+#define _GREENSOCS_THREAD_SAFE_EXTENSION_H
+
+#include <systemc>
+#include <tlm>
+
+namespace gs {
+
+/**
+ * @class Thread safe target TLM extension
+ *
+ * @brief Lets a target declare that its b_transport may be called from any
+ * thread.
+ *
+ * @details An initiator which is able to call b_transport from outside of the
+ * SystemC thread attaches this extension (unset) to a transaction. On the way
+ * back, a target which is thread safe, or a router configured with
+ * `<target>.thread_safe = true`, sets the address range it covers. Routers
+ * translate the range into their own address space, so the initiator receives
+ * a range in its address space. Subsequent accesses in that range may then be
+ * issued directly from the initiator thread.
+ *
+ * A target declaring itself thread safe must not call wait() and must protect
+ * its own state.
+ */
+class ThreadSafeExtension : public tlm::tlm_extension<ThreadSafeExtension>
+{
+    bool m_set = false;
+    sc_dt::uint64 m_start = 0;
+    sc_dt::uint64 m_end = 0;
+
+public:
+    ThreadSafeExtension() = default;
+    ThreadSafeExtension(const ThreadSafeExtension&) = default;
+
+    void set(sc_dt::uint64 start, sc_dt::uint64 end)
+    {
+        m_set = true;
+        m_start = start;
+        m_end = end;
+    }
+    void reset() { m_set = false; }
+    bool is_set() const { return m_set; }
+    sc_dt::uint64 get_start() const { return m_start; }
+    sc_dt::uint64 get_end() const { return m_end; }
+
+public:
+    virtual tlm_extension_base* clone() const override { return new ThreadSafeExtension(*this); }
+
+    virtual void copy_from(const tlm_extension_base& ext) override
+    {
+        const ThreadSafeExtension& other = static_cast<const ThreadSafeExtension&>(ext);
+        *this = other;
+    }
+};
+} // namespace gs
+#endif
@@ -0,0 +1,160 @@
+/*
+ * Copyright (c) 2024 Qualcomm Innovation Center, Inc. All Rights Reserved.
+ *
+ * SPDX-License-Identifier: BSD-3-Clause
+ */
+
+#ifndef _GREENSOCS_BASE_COMPONENTS_TRACE_EXPORTER_H
+#define _GREENSOCS_BASE_COMPONENTS_TRACE_EXPORTER_H
+
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <mutex>
+#include <ostream>
+#include <string>
+
+#include <cci_configuration>
+#include <systemc>
+
+#include <scp/report.h>
+
+#include <pre_suspending_sc_support.h>
+
+namespace gs {
+
+/**
+ * @brief Singleton writing a timeline of the simulation activity in the Chrome trace event format
+ * (JSON), which can be loaded in Perfetto (ui.perfetto.dev) or chrome://tracing.
+ *
+ * Events are placed on a wall clock timeline, one track per host thread, and carry the SystemC time
+ * at which they started in their arguments (`sc_ns`). It is configured from the global broker, e.g.
+ * in Lua:
+ *
+ *     trace = {
+ *         file = "trace.json",
+ *         kernel = true,
+ *     }
+ *
+ *   - file   : output file, tracing is disabled when not set.
+ *   - kernel : also record SystemC delta cycles and time steps (verbose, needs SystemC 3.0).
+ *
+ * The configuration is read by init(), which must be called on the SystemC thread during
+ * elaboration, before the threads which record events are started; the module factory container
+ * does it when it is constructed. Events can then be recorded from any thread. The file is
+ * terminated when the process exits, including on a signal handled by SigHandler.
+ */
+class TraceExporter
+#ifdef SC_HAS_STAGE_CALLBACKS
+    : public sc_core::sc_stage_callback_if
+#endif
+{
+    SCP_LOGGER((), "TraceExporter");
+
+public:
+    using clock = std::chrono::steady_clock;
+
+    static TraceExporter& get();
+
+    /** Load the configuration from the global broker and open the output file, once. */
+    static void init();
+
+    TraceExporter(TraceExporter const&) = delete;
+    void operator=(TraceExporter const&) = delete;
+
+    bool enabled() const { return m_file != nullptr; }
+
+    /**
+     * Record an interval of the calling thread. `args` is either empty or the content of a JSON
+     * object (e.g. `"addr":4096`).
+     */
+    void complete(const char* cat, const char* name, clock::time_point start, clock::time_point end,
+                  uint64_t sc_ns, const std::string& args = "");
+
+    /** Record a point event on the calling thread. */
+    void instant(const char* cat, const char* name, const std::string& args = "");
+
+    /** Name the track of the calling thread. */
+    void name_thread(const std::string& name);
+
+    void flush();
+
+    /** Terminate the JSON array and close the file, nothing is recorded afterwards. */
+    void close();
+
+    const char* name() const { return "TraceExporter"; }
+
+    /**
+     * @brief Record the lifetime of the object as an interval of the calling thread.
+     * Does nothing when tracing is disabled.
+     */
+    class span
+    {
+        const char* m_cat;
+        const char* m_name;
+        std::string m_args;
+        bool m_enabled;
+        uint64_t m_sc_ns = 0;
+        clock::time_point m_start;
+
+    public:
+        span(const char* cat, const char* name): m_cat(cat), m_name(name), m_enabled(get().enabled())
+        {
+            if (m_enabled) {
+                m_sc_ns = sc_now_ns();
+                m_start = clock::now();
+            }
+        }
+
+        template <typename F>
+        span(const char* cat, const char* name, F args_fn): span(cat, name)
+        {
+            if (m_enabled) m_args = args_fn();
+        }
+
+        ~span()
+        {
+            if (m_enabled) get().complete(m_cat, m_name, m_start, clock::now(), m_sc_ns, m_args);
+        }
+
+        span(const span&) = delete;
+        span& operator=(const span&) = delete;
+    };
+
+    /* SystemC time in ns. From other threads this is only indicative. */
+    static uint64_t sc_now_ns()
+    {
+        return sc_core::sc_time_stamp().value() / sc_core::sc_time(1, sc_core::SC_NS).value();
+    }
+
+private:
+    TraceExporter() = default;
+    ~TraceExporter();
+
+#ifdef SC_HAS_STAGE_CALLBACKS
+    virtual void stage_callback(const sc_core::sc_stage& stage) override;
+#endif
+
+    int tid();
+    void write_event(const std::string& ev);
+
+    /* JSON string, quoted and escaped */
+    static void put_string(std::ostream& os, const char* str);
+    /* Trace time stamp or duration: microseconds, with the nanoseconds as a fixed point fraction */
+    static void put_us(std::ostream& os, std::chrono::nanoseconds d);
+
+    std::atomic<std::FILE*> m_file{ nullptr };
+    bool m_loaded = false;
+    std::mutex m_mutex;
+    bool m_first = true;
+    int m_pid = 0;
+    std::atomic<int> m_next_tid{ 1 };
+    clock::time_point m_origin;
+    clock::time_point m_step_start;
+    uint64_t m_step_sc_ns = 0;
+};
+
+} // namespace gs
+
+#endif // _GREENSOCS_BASE_COMPONENTS_TRACE_EXPORTER_H
@@ -0,0 +1,383 @@
+/*
+ * Copyright (c) 2024 Qualcomm Innovation Center, Inc. All Rights Reserved.
+ *
+ * SPDX-License-Identifier: BSD-3-Clause
+ */
+
+#include "io_reactor.h"
+#include "thread_placement.h"
+
+#include <algorithm>
+#include <cerrno>
+#include <cstring>
+
+#ifndef _WIN32
+#include <fcntl.h>
+#include <poll.h>
+#include <unistd.h>
+#endif
+#if defined(__linux__)
+#include <sys/epoll.h>
+#include <sys/eventfd.h>
+#include <sys/timerfd.h>
+#endif
+
+constexpr uint32_t gs::IoReactor::READABLE;
+constexpr uint32_t gs::IoReactor::WRITABLE;
+constexpr uint32_t gs::IoReactor::HANGUP;
+constexpr uint64_t gs::IoReactor::TIMER_KEY;
+constexpr uint64_t gs::IoReactor::WAKE_KEY;
+constexpr uint64_t gs::IoReactor::NO_KEY;
+
+gs::IoReactor::IoReactor()
+{
+#if defined(__linux__)
+    m_epfd = epoll_create1(EPOLL_CLOEXEC);
+    m_wake_fd[0] = m_wake_fd[1] = eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+    if (m_epfd < 0 || m_wake_fd[0] < 0) {
+        SCP_FATAL(())("Unable to set up the I/O reactor: {}", std::strerror(errno));
+    }
+    struct epoll_event ev = {};
+    ev.events = EPOLLIN;
+    ev.data.u64 = WAKE_KEY;
+    epoll_ctl(m_epfd, EPOLL_CTL_ADD, m_wake_fd[0], &ev);
+#elif !defined(_WIN32)
+    if (pipe(m_wake_fd) < 0) {
+        SCP_FATAL(())("Unable to set up the I/O reactor: {}", std::strerror(errno));
+    }
+    fcntl(m_wake_fd[0], F_SETFL, O_NONBLOCK);
+    fcntl(m_wake_fd[1], F_SETFL, O_NONBLOCK);
+#endif
+
+    /* Never deleted: it belongs to the simulation context, which may be gone when we are */
+    m_sysc_event = new async_event(false); // starve if no more jobs provided
+    sc_core::sc_spawn_options opts;
+    opts.spawn_method();
+    opts.set_sensitivity(m_sysc_event);
+    opts.dont_initialize();
+    sc_core::sc_spawn([this]() { run_posted(); }, sc_core::sc_gen_unique_name("io_reactor"), &opts);
+
+#ifndef _WIN32
+    m_thread = std::thread(&IoReactor::loop, this);
+#endif
+}
+
+gs::IoReactor::~IoReactor()
+{
+    m_stop = true;
+    if (m_thread.joinable()) {
+        wake();
+        m_thread.join();
+    }
+#ifndef _WIN32
+    for (auto& s : m_sources) {
+        if (s.first & TIMER_KEY) {
+            ::close(s.second->fd);
+        }
+    }
+    if (m_epfd >= 0) ::close(m_epfd);
+    if (m_wake_fd[0] >= 0) ::close(m_wake_fd[0]);
+    if (m_wake_fd[1] >= 0 && m_wake_fd[1] != m_wake_fd[0]) ::close(m_wake_fd[1]);
+#endif
+}
+
+gs::IoReactor& gs::IoReactor::get()
+{
+    static IoReactor instance;
+    return instance;
+}
+
+void gs::IoReactor::wake()
+{
+#ifndef _WIN32
+#if defined(__linux__)
+    uint64_t one = 1;
+#else
+    uint8_t one = 1;
+#endif
+    if (::write(m_wake_fd[1], &one, sizeof(one)) < 0 && errno != EAGAIN) {
+        SCP_WARN(())("Unable to wake the I/O reactor: {}", std::strerror(errno));
+    }
+#endif
+}
+
+bool gs::IoReactor::add_fd(int fd, uint32_t events, fd_handler handler)
+{
+    auto s = std::make_shared<source>();
+    s->fd = fd;
+    s->events = events;
+    s->on_fd = std::move(handler);
+
+    std::lock_guard<std::mutex> lock(m_mutex);
+#if defined(__linux__)
+    struct epoll_event ev = {};
+    ev.events = ((events & READABLE) ? uint32_t(EPOLLIN) : 0) | ((events & WRITABLE) ? uint32_t(EPOLLOUT) : 0);
+    ev.data.u64 = uint64_t(fd);
+    if (epoll_ctl(m_epfd, EPOLL_CTL_ADD, fd, &ev) < 0) {
+        if (errno != EPERM) {
+            SCP_WARN(())("Unable to watch fd {}: {}", fd, std::strerror(errno));
+            return false;
+        }
+        /* Regular files are always ready and cannot be given to epoll */
+        m_always_ready.insert(uint64_t(fd));
+        m_sources[uint64_t(fd)] = s;
+        wake();
+        return true;
+    }
+#endif
+    m_sources[uint64_t(fd)] = s;
+#if !defined(__linux__)
+    wake();
+#endif
+    return true;
+}
+
+int gs::IoReactor::add_timer(std::chrono::nanoseconds delay, std::chrono::nanoseconds period, timer_handler handler)
+{
+    auto s = std::make_shared<source>();
+    s->on_timer = std::move(handler);
+    s->deadline = clock::now() + delay;
+    s->period = period;
+
+    std::lock_guard<std::mutex> lock(m_mutex);
+    int id = m_next_timer++;
+    uint64_t key = TIMER_KEY | uint64_t(id);
+#if defined(__linux__)
+    s->fd = timerfd_create(CLOCK_MONOTONIC, TFD_NONBLOCK | TFD_CLOEXEC);
+    if (s->fd < 0) {
+        SCP_WARN(())("Unable to create a timer: {}", std::strerror(errno));
+        return -1;
+    }
+    /* A zero it_value disarms the timer, fire right away instead */
+    if (delay.count() <= 0) delay = std::chrono::nanoseconds(1);
+    struct itimerspec its = {};
+    its.it_value.tv_sec = delay.count() / 1000000000;
+    its.it_value.tv_nsec = delay.count() % 1000000000;
+    its.it_interval.tv_sec = period.count() / 1000000000;
+    its.it_interval.tv_nsec = period.count() % 1000000000;
+    timerfd_settime(s->fd, 0, &its, nullptr);
+
+    struct epoll_event ev = {};
+    ev.events = EPOLLIN;
+    ev.data.u64 = key;
+    epoll_ctl(m_epfd, EPOLL_CTL_ADD, s->fd, &ev);
+    m_sources[key] = s;
+#else
+    m_sources[key] = s;
+    wake();
+#endif
+    return id;
+}
+
+void gs::IoReactor::remove_fd(int fd) { remove(uint64_t(fd)); }
+
+void gs::IoReactor::remove_timer(int id)
+{
+    if (id >= 0) remove(TIMER_KEY | uint64_t(id));
+}
+
+void gs::IoReactor::remove(uint64_t key)
+{
+    std::unique_lock<std::mutex> lock(m_mutex);
+    auto it = m_sources.find(key);
+    if (it == m_sources.end()) {
+        return;
+    }
+    int fd = it->second->fd;
+    m_sources.erase(it);
+    m_always_ready.erase(key);
+#if defined(__linux__)
+    epoll_ctl(m_epfd, EPOLL_CTL_DEL, fd, nullptr);
+#else
+    wake();
+#endif
+
+    if (std::this_thread::get_id() != m_thread.get_id()) {
+        m_dispatch_done.wait(lock, [&]() { return m_dispatching != key; });
+    }
+#ifndef _WIN32
+    if (key & TIMER_KEY) {
+        ::close(fd);
+    }
+#endif
+}
+
+void gs::IoReactor::dispatch(uint64_t key, uint32_t events)
+{
+    std::shared_ptr<source> s;
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        auto it = m_sources.find(key);
+        if (it == m_sources.end()) {
+            return; // removed meanwhile
+        }
+        s = it->second;
+        m_dispatching = key;
+    }
+
+    if (key & TIMER_KEY) {
+#if defined(__linux__)
+        uint64_t expirations;
+        if (::read(s->fd, &expirations, sizeof(expirations)) == sizeof(expirations)) {
+            s->on_timer();
+        }
+#else
+        s->on_timer();
+#endif
+    } else {
+        s->on_fd(events);
+    }
+
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_dispatching = NO_KEY;
+    }
+    m_dispatch_done.notify_all();
+
+    if ((key & TIMER_KEY) && s->period.count() == 0) {
+        remove(key); // one shot
+    }
+}
+
+void gs::IoReactor::loop()
+{
+#ifndef _WIN32
+    ThreadPlacement::get().apply(ThreadPlacement::IO, "io_reactor");
+
+#if defined(__linux__)
+    constexpr int MAX_EVENTS = 64;
+    struct epoll_event evs[MAX_EVENTS];
+
+    while (!m_stop) {
+        int timeout;
+        {
+            std::lock_guard<std::mutex> lock(m_mutex);
+            timeout = m_always_ready.empty() ? -1 : 0;
+        }
+        int n = epoll_wait(m_epfd, evs, MAX_EVENTS, timeout);
+        if (n < 0) {
+            if (errno == EINTR) continue;
+            SCP_FATAL(())("epoll_wait failed: {}", std::strerror(errno));
+        }
+
+        for (int i = 0; i < n; i++) {
+            uint64_t key = evs[i].data.u64;
+            if (key == WAKE_KEY) {
+                uint64_t v;
+                while (::read(m_wake_fd[0], &v, sizeof(v)) > 0) {
+                }
+                continue;
+            }
+            uint32_t events = ((evs[i].events & EPOLLIN) ? READABLE : 0) | ((evs[i].events & EPOLLOUT) ? WRITABLE : 0) |
+                              ((evs[i].events & (EPOLLHUP | EPOLLERR)) ? HANGUP : 0);
+            dispatch(key, events);
+        }
+
+        if (timeout == 0) {
+            std::vector<uint64_t> ready;
+            {
+                std::lock_guard<std::mutex> lock(m_mutex);
+                ready.assign(m_always_ready.begin(), m_always_ready.end());
+            }
+            for (auto key : ready) {
+                dispatch(key, READABLE | WRITABLE);
+            }
+        }
+    }
+#else
+    std::vector<struct pollfd> fds;
+    std::vector<uint64_t> keys;
+
+    while (!m_stop) {
+        fds.assign(1, { m_wake_fd[0], POLLIN, 0 });
+        keys.assign(1, WAKE_KEY);
+        int timeout = -1;
+        {
+            std::lock_guard<std::mutex> lock(m_mutex);
+            auto now = clock::now();
+            for (auto& s : m_sources) {
+                if (s.first & TIMER_KEY) {
+                    auto left = std::chrono::duration_cast<std::chrono::milliseconds>(s.second->deadline - now);
+                    int ms = left.count() > 0 ? int(left.count()) + 1 : 0;
+                    timeout = (timeout < 0) ? ms : std::min(timeout, ms);
+                } else {
+                    uint32_t events = s.second->events;
+                    short pev = ((events & READABLE) ? POLLIN : 0) | ((events & WRITABLE) ? POLLOUT : 0);
+                    fds.push_back({ s.second->fd, pev, 0 });
+                    keys.push_back(s.first);
+                }
+            }
+        }
+
+        int n = poll(fds.data(), fds.size(), timeout);
+        if (n < 0) {
+            if (errno == EINTR) continue;
+            SCP_FATAL(())("poll failed: {}", std::strerror(errno));
+        }
+
+        if (fds[0].revents) {
+            uint8_t v[64];
+            while (::read(m_wake_fd[0], v, sizeof(v)) > 0) {
+            }
+        }
+        for (size_t i = 1; i < fds.size(); i++) {
+            short r = fds[i].revents;
+            if (r) {
+                dispatch(keys[i], ((r & POLLIN) ? READABLE : 0) | ((r & POLLOUT) ? WRITABLE : 0) |
+                                      ((r & (POLLHUP | POLLERR | POLLNVAL)) ? HANGUP : 0));
+            }
+        }
+
+        std::vector<uint64_t> due;
+        {
+            std::lock_guard<std::mutex> lock(m_mutex);
+            auto now = clock::now();
+            for (auto& s : m_sources) {
+                if ((s.first & TIMER_KEY) && s.second->deadline <= now) {
+                    s.second->deadline += s.second->period;
+                    due.push_back(s.first);
+                }
+            }
+        }
+        for (auto key : due) {
+            dispatch(key, 0);
+        }
+    }
+#endif
+#endif
+}
+
+void gs::IoReactor::post(std::function<void()> job)
+{
+    {
+        std::lock_guard<std::mutex> lock(m_posted_mutex);
+        m_posted.push_back(std::move(job));
+    }
+    m_sysc_event->async_notify();
+}
+
+void gs::IoReactor::attach()
+{
+    if (m_attached++ == 0) {
+        m_sysc_event->async_attach_suspending();
+    }
+}
+
+void gs::IoReactor::detach()
+{
+    if (m_attached > 0 && --m_attached == 0) {
+        m_sysc_event->async_detach_suspending();
+    }
+}
+
+void gs::IoReactor::run_posted()
+{
+    std::vector<std::function<void()>> jobs;
+    {
+        std::lock_guard<std::mutex> lock(m_posted_mutex);
+        jobs.swap(m_posted);
+    }
+    for (auto& job : jobs) {
+        job();
+    }
+}
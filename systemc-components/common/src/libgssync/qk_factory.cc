@@ -15,6 +15,10 @@ std::shared_ptr<gs::tlm_quantumkeeper_extended> tlm_quantumkeeper_factory(std::s
     if (name == "multithread-quantum") return std::make_shared<gs::tlm_quantumkeeper_multi_quantum>();
     if (name == "multithread-adaptive") return std::make_shared<gs::tlm_quantumkeeper_multi_adaptive>();
     if (name == "multithread-rolling") return std::make_shared<gs::tlm_quantumkeeper_multi_rolling>();
+#ifdef SC_HAS_STAGE_CALLBACKS
+    if (name == "multithread-lookahead") return std::make_shared<gs::tlm_quantumkeeper_multi_lookahead>();
+    if (name == "multithread-distributed") return std::make_shared<gs::tlm_quantumkeeper_multi_distributed>();
+#endif
     if (name == "multithread-unconstrained") return std::make_shared<gs::tlm_quantumkeeper_unconstrained>();
     if (name == "multithread-freerunning") return std::make_shared<gs::tlm_quantumkeeper_freerunning>();
     return nullptr;
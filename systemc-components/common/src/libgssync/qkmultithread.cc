@@ -8,6 +8,7 @@
 #include <mutex>
 #include <condition_variable>
 #include <functional>
+#include <memory>
 #ifndef SC_INCLUDE_DYNAMIC_PROCESSES
 #define SC_INCLUDE_DYNAMIC_PROCESSES
 #endif
@@ -20,8 +21,48 @@
 #include <qkmultithread.h>
 #include <libgsutils.h>
 #include <uutils.h>
+#include <thread_placement.h>
+#include <trace_exporter.h>
 
 namespace gs {
+
+/* Number of budget checks made by an out of budget thread before parking */
+static constexpr int SYNC_SPIN_COUNT = 2000;
+
+/* Copy of the global quantum value, 0 until set through tlm_quantumkeeper_extended */
+static std::atomic<sc_dt::uint64> global_quantum_value(0);
+
+sc_core::sc_time tlm_quantumkeeper_extended::get_global_quantum()
+{
+    sc_dt::uint64 v = global_quantum_value.load(std::memory_order_relaxed);
+    return v ? sc_core::sc_time::from_value(v) : tlm_utils::tlm_quantumkeeper::get_global_quantum();
+}
+
+void tlm_quantumkeeper_extended::set_global_quantum(const sc_core::sc_time& q)
+{
+    tlm_utils::tlm_quantumkeeper::set_global_quantum(q);
+    global_quantum_value.store(q.value(), std::memory_order_relaxed);
+}
+
+static inline void cpu_relax()
+{
+#if defined(__x86_64__) || defined(__i386__)
+    __builtin_ia32_pause();
+#elif defined(__aarch64__)
+    asm volatile("yield" ::: "memory");
+#endif
+}
+
+/* Wake the threads waiting for budget, only taking the lock if there are some */
+void tlm_quantumkeeper_multithread::budget_moved()
+{
+    m_budget_gen.fetch_add(1);
+    if (m_extern_waiting.load() != 0) {
+        std::lock_guard<std::mutex> lock(mutex);
+        cond.notify_all();
+    }
+}
+
 /* constantly monitor SystemC and dont let it get ahead of the
    local_time - this is the tlm2.0 rule (h) */
 void tlm_quantumkeeper_multithread::timehandler()
@@ -32,33 +73,61 @@ void tlm_quantumkeeper_multithread::timehandler()
         m_systemc_waiting = false;
         SCP_TRACE(())("Unsuspending");
         sc_core::sc_unsuspend_all();
+        m_profile.count_unsuspend();
+        budget_moved();
         return;
     }
+
+    sc_core::sc_time quantum = tlm_quantumkeeper_extended::get_global_quantum();
+    bool moved = (sc_core::sc_time_stamp() != m_last_sysc_time) || (quantum != m_last_quantum);
+    m_last_sysc_time = sc_core::sc_time_stamp();
+    m_last_quantum = quantum;
+
     if ((get_current_time() > sc_core::sc_time_stamp())) {
         // UnSuspend SystemC if local time is ahead of systemc time
         m_systemc_waiting = false;
         SCP_TRACE(())("Unsuspending");
         sc_core::sc_unsuspend_all();
-        sc_core::sc_time m_quantum = tlm_utils::tlm_quantumkeeper::get_global_quantum();
-        m_tick.notify(std::min(get_current_time() - sc_core::sc_time_stamp(), m_quantum));
+        m_profile.count_unsuspend();
+        m_tick.notify(std::min(get_current_time() - sc_core::sc_time_stamp(), quantum));
     } else {
         // Suspend SystemC if SystemC has caught up with our
         // local_time
         m_systemc_waiting = true;
         SCP_TRACE(())("Suspending");
         sc_core::sc_suspend_all();
+        m_profile.count_suspend();
+        sysc_suspending();
+        // sync() only notifies us when it sees m_systemc_waiting, re-check
+        // in case the local time moved before it was set
+        if (get_current_time() > sc_core::sc_time_stamp()) {
+            m_tick.notify(sc_core::SC_ZERO_TIME);
+        }
     }
 
-    cond.notify_all(); // nudge the sync thread, in case it's waiting for us
+    if (moved) {
+        budget_moved(); // nudge the sync thread, in case it's waiting for us
+    }
 }
 
-tlm_quantumkeeper_multithread::~tlm_quantumkeeper_multithread() { cond.notify_all(); }
+tlm_quantumkeeper_multithread::~tlm_quantumkeeper_multithread() { budget_moved(); }
 
 // The quantum keeper should be instanced in SystemC
 // but it's functions may be called from other threads
 // The QK may be instanced outside of elaboration
 tlm_quantumkeeper_multithread::tlm_quantumkeeper_multithread()
-    : m_systemc_thread_id(std::this_thread::get_id()), status(NONE), m_tick(false) /* handle attach manually */
+    : m_systemc_thread_id(std::this_thread::get_id())
+    , m_budget_gen(0)
+    , m_stat_syncs(0)
+    , m_stat_waits(0)
+    , m_stat_wait_ns(0)
+    , m_stat_idle_ns(0)
+    , m_stat_io(0)
+    , m_systemc_waiting(false)
+    , m_extern_waiting(0)
+    , m_tick(false) /* handle attach manually */
+    , m_local_ticks(0)
+    , status(NONE)
 {
     SCP_TRACE(())("Constructor");
     sc_core::sc_spawn_options opt;
@@ -86,11 +155,22 @@ bool tlm_quantumkeeper_multithread::is_sysc_thread() const
 void tlm_quantumkeeper_multithread::start(std::function<void()> job)
 {
     SCP_TRACE(())("Start");
+    if (status == STOPPED) {
+        auto idle = std::chrono::steady_clock::now() - m_stopped_at;
+        m_stat_idle_ns.fetch_add(std::chrono::duration_cast<std::chrono::nanoseconds>(idle).count(),
+                                 std::memory_order_relaxed);
+    }
+    if (sync_profile::current() == &m_profile && m_profile.get_state() == sync_profile::IDLE) {
+        m_profile.switch_to(sync_profile::RUNNING);
+    }
     status = RUNNING;
     m_tick.async_attach_suspending();
     m_tick.notify(sc_core::SC_ZERO_TIME);
     if (job) {
-        std::thread t(job);
+        std::thread t([job]() {
+            ThreadPlacement::get().apply(ThreadPlacement::SYNC, "qk-worker");
+            job();
+        });
         m_worker_thread = std::move(t);
     }
 }
@@ -99,10 +179,14 @@ void tlm_quantumkeeper_multithread::stop()
 {
     if (status != STOPPED) {
         SCP_TRACE(())("Stop");
+        m_stopped_at = std::chrono::steady_clock::now();
+        if (sync_profile::current() == &m_profile && m_profile.get_state() == sync_profile::RUNNING) {
+            m_profile.switch_to(sync_profile::IDLE);
+        }
         status = STOPPED;
 
         m_tick.notify(sc_core::SC_ZERO_TIME);
-        cond.notify_all();
+        budget_moved();
         m_tick.async_detach_suspending();
 
         if (m_worker_thread.joinable()) {
@@ -115,7 +199,7 @@ void tlm_quantumkeeper_multithread::stop()
 /* return the time remaining till the next sync point*/
 sc_core::sc_time tlm_quantumkeeper_multithread::time_to_sync()
 {
-    sc_core::sc_time m_quantum = tlm_utils::tlm_quantumkeeper::get_global_quantum();
+    sc_core::sc_time m_quantum = tlm_quantumkeeper_extended::get_global_quantum();
     sc_core::sc_time q = sc_core::sc_time_stamp() + (m_quantum * 2);
     if (q >= get_current_time()) {
         return q - get_current_time();
@@ -128,15 +212,16 @@ sc_core::sc_time tlm_quantumkeeper_multithread::time_to_sync()
  * Overloaded Functions
  */
 
-void tlm_quantumkeeper_multithread::inc(const sc_core::sc_time& t) { m_local_time += t; }
+void tlm_quantumkeeper_multithread::inc(const sc_core::sc_time& t) { m_local_ticks.fetch_add(t.value()); }
 
 /* NB, if used outside SystemC, SystemC time may vary */
 void tlm_quantumkeeper_multithread::set(const sc_core::sc_time& t)
 {
     SCP_TRACE(())("Set {}s", t.to_seconds());
     // quietly refuse to move time backwards
-    if (t + sc_core::sc_time_stamp() >= m_local_time) {
-        m_local_time = t + sc_core::sc_time_stamp(); // NB, we store the absolute time.
+    sc_dt::uint64 abs = (t + sc_core::sc_time_stamp()).value(); // NB, we store the absolute time.
+    sc_dt::uint64 cur = m_local_ticks.load();
+    while (abs >= cur && !m_local_ticks.compare_exchange_weak(cur, abs)) {
     }
     m_tick.notify(sc_core::SC_ZERO_TIME);
 }
@@ -144,43 +229,97 @@ void tlm_quantumkeeper_multithread::set(const sc_core::sc_time& t)
 void tlm_quantumkeeper_multithread::sync()
 {
     if (is_sysc_thread()) {
-        assert(m_local_time >= sc_core::sc_time_stamp());
-        sc_core::sc_time t = m_local_time - sc_core::sc_time_stamp();
+        assert(get_current_time() >= sc_core::sc_time_stamp());
+        sc_core::sc_time t = get_current_time() - sc_core::sc_time_stamp();
         m_tick.notify(sc_core::SC_ZERO_TIME);
         if (status != STOPPED) {
             sc_core::wait(t);
         }
-    } else {
-        std::unique_lock<std::mutex> lock(mutex);
-        /* Wake up the SystemC thread if it's waiting for us to keep up */
+        return;
+    }
+
+    m_stat_syncs.fetch_add(1, std::memory_order_relaxed);
+
+    /* Wake up the SystemC thread if it's waiting for us to keep up */
+    if (m_systemc_waiting.load()) {
         m_tick.notify(sc_core::SC_ZERO_TIME);
-        /* Wait for some run budget */
-        m_extern_waiting = true;
-        cond.wait(lock, [this] { return status != RUNNING || time_to_sync() != sc_core::SC_ZERO_TIME; });
-        m_extern_waiting = false;
+    }
+
+    bool waited = false;
+    std::chrono::steady_clock::time_point wait_start;
+    std::unique_ptr<sync_profile::scope> prof_scope;
+    std::unique_ptr<TraceExporter::span> trace;
+
+    for (;;) {
+        uint64_t gen = m_budget_gen.load();
+
+        if (status != RUNNING || time_to_sync() != sc_core::SC_ZERO_TIME) {
+            if (waited) {
+                auto wait = std::chrono::steady_clock::now() - wait_start;
+                m_stat_wait_ns.fetch_add(std::chrono::duration_cast<std::chrono::nanoseconds>(wait).count(),
+                                         std::memory_order_relaxed);
+            }
+            return;
+        }
+
+        if (!waited) {
+            waited = true;
+            wait_start = std::chrono::steady_clock::now();
+            m_stat_waits.fetch_add(1, std::memory_order_relaxed);
+            prof_scope.reset(new sync_profile::scope(sync_profile::BUDGET_WAIT));
+            if (TraceExporter::get().enabled()) trace.reset(new TraceExporter::span("qk", "budget wait"));
+        }
+
+        /* Out of budget, it only grows once SystemC moves: spin a bit, then park */
+        for (int i = 0; i < SYNC_SPIN_COUNT && m_budget_gen.load(std::memory_order_acquire) == gen; i++) {
+            cpu_relax();
+        }
+
+        if (m_budget_gen.load() == gen) {
+            std::unique_lock<std::mutex> lock(mutex);
+            m_extern_waiting++;
+            cond.wait(lock, [this, gen] { return m_budget_gen.load() != gen; });
+            m_extern_waiting--;
+        }
     }
 }
 
 void tlm_quantumkeeper_multithread::reset()
 {
     // As we use absolute time, we reset to the current sc_time
-    m_local_time = sc_core::sc_time_stamp();
+    m_local_ticks.store(sc_core::sc_time_stamp().value());
     m_tick.notify(sc_core::SC_ZERO_TIME);
+    budget_moved();
 }
 
-sc_core::sc_time tlm_quantumkeeper_multithread::get_current_time() const { return m_local_time; }
+sc_core::sc_time tlm_quantumkeeper_multithread::get_current_time() const
+{
+    return sc_core::sc_time::from_value(m_local_ticks.load());
+}
 
 /* NB not thread safe, you're time may vary, you should really be
  * calling this from SystemC */
 sc_core::sc_time tlm_quantumkeeper_multithread::get_local_time() const
 {
     sc_core::sc_time sc_t = sc_core::sc_time_stamp();
-    if (m_local_time >= sc_t)
-        return m_local_time - sc_t;
+    sc_core::sc_time local = get_current_time();
+    if (local >= sc_t)
+        return local - sc_t;
     else
         return sc_core::SC_ZERO_TIME;
 }
 
+tlm_quantumkeeper_extended::sync_stats tlm_quantumkeeper_multithread::get_sync_stats() const
+{
+    sync_stats s;
+    s.syncs = m_stat_syncs.load(std::memory_order_relaxed);
+    s.waits = m_stat_waits.load(std::memory_order_relaxed);
+    s.wait_ns = m_stat_wait_ns.load(std::memory_order_relaxed);
+    s.idle_ns = m_stat_idle_ns.load(std::memory_order_relaxed);
+    s.io = m_stat_io.load(std::memory_order_relaxed);
+    return s;
+}
+
 bool tlm_quantumkeeper_multithread::need_sync()
 {
     // By default we recommend to sync, but other sync policies may vary
@@ -0,0 +1,15 @@
+/*
+ * Copyright (c) 2024 Qualcomm Innovation Center, Inc. All Rights Reserved.
+ *
+ * SPDX-License-Identifier: BSD-3-Clause
+ */
+
+#include <sync_profile.h>
+
+namespace gs {
+sync_profile*& sync_profile::current()
+{
+    static thread_local sync_profile* p = nullptr;
+    return p;
+}
+} // namespace gs
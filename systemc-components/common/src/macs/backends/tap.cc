@@ -10,8 +10,8 @@
 #include <fcntl.h>
 #include <net/if.h>
 #include <netinet/in.h>
-#include <thread>
 #include <unistd.h>
+#include <vector>
 #ifdef __APPLE__
 #include <net/if_utun.h> // UTUN_CONTROL_NAME
 #else
@@ -27,6 +27,8 @@
 #include <systemc>
 #include <scp/report.h>
 
+#include <io_reactor.h>
+
 #include "backends/tap.h"
 
 using namespace sc_core;
@@ -65,7 +67,10 @@ void NetworkBackendTap::open(std::string& tun)
 #endif
     SCP_DEBUG(SCMOD) << "TAP opened";
 
-    new std::thread(&NetworkBackendTap::rcv_thread, this);
+    ::fcntl(m_fd, F_SETFL, ::fcntl(m_fd, F_GETFL, 0) | O_NONBLOCK);
+    gs::IoReactor::get().add_fd(m_fd, gs::IoReactor::READABLE, [this](uint32_t) { read_frames(); });
+    /* Frames may come from the host at any time, do not let the simulation starve */
+    gs::IoReactor::get().attach();
 }
 
 void NetworkBackendTap::close()
@@ -73,40 +78,46 @@ void NetworkBackendTap::close()
     if (m_fd < 0) {
         return;
     }
+    gs::IoReactor::get().remove_fd(m_fd);
+    gs::IoReactor::get().detach();
     ::close(m_fd);
     m_fd = -1;
 }
 
-void* NetworkBackendTap::rcv_thread()
+/* Runs on the I/O reactor thread */
+void NetworkBackendTap::read_frames()
 {
+    std::vector<Payload*> frames;
+
     for (;;) {
         Payload* frame = new Payload(9000);
 
         int r = ::read(m_fd, frame->data(), (int)frame->capacity());
-        if (r > 0) {
-            if (r < 60) {
-                /*
-                 * Pad with zeroes as the minimal payload size is 60 bytes
-                 * (60 bytes of data + 4 bytes of crc -> 64bytes)
-                 */
-                std::memset(frame->data() + r, 0, 60 - r);
-                r = 60;
-            }
-            frame->resize(r);
-        } else {
-            /* error */
+        if (r <= 0) {
+            /* EAGAIN or error */
             delete frame;
+            break;
         }
-
-        std::lock_guard<std::mutex> lock(m_mutex);
-
-        if (r > 0) {
-            SCP_TRACE(SCMOD) << "frame of size " << r << " EXT -> VP";
-            m_queue.push(frame);
-        }
-        if (!m_queue.empty()) {
-            m_event.async_notify();
+        if (r < 60) {
+            /*
+             * Pad with zeroes as the minimal payload size is 60 bytes
+             * (60 bytes of data + 4 bytes of crc -> 64bytes)
+             */
+            std::memset(frame->data() + r, 0, 60 - r);
+            r = 60;
         }
+        frame->resize(r);
+        SCP_TRACE(SCMOD) << "frame of size " << r << " EXT -> VP";
+        frames.push_back(frame);
+    }
+
+    if (!frames.empty()) {
+        gs::IoReactor::get().post([this, frames]() {
+            for (auto frame : frames) {
+                m_queue.push(frame);
+            }
+            m_event.notify(sc_core::SC_ZERO_TIME);
+        });
     }
 }
 
@@ -114,8 +125,6 @@ void NetworkBackendTap::rcv()
 {
     Payload* frame;
 
-    std::lock_guard<std::mutex> lock(m_mutex);
-
     while (!m_queue.empty()) {
         if (m_can_receive(m_opaque)) {
             frame = m_queue.front();
@@ -0,0 +1,183 @@
+/*
+ * Copyright (c) 2024 Qualcomm Innovation Center, Inc. All Rights Reserved.
+ *
+ * SPDX-License-Identifier: BSD-3-Clause
+ */
+
+#include "thread_placement.h"
+
+#include <cciutils.h>
+
+#include <cerrno>
+#include <cstring>
+#include <sstream>
+
+#ifndef _WIN32
+#include <pthread.h>
+#include <sched.h>
+#include <sys/resource.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#endif
+
+constexpr const char* gs::ThreadPlacement::SYSTEMC;
+constexpr const char* gs::ThreadPlacement::VCPU;
+constexpr const char* gs::ThreadPlacement::SYNC;
+constexpr const char* gs::ThreadPlacement::TIMER;
+constexpr const char* gs::ThreadPlacement::IO;
+
+gs::ThreadPlacement& gs::ThreadPlacement::get()
+{
+    static ThreadPlacement instance;
+    return instance;
+}
+
+void gs::ThreadPlacement::init()
+{
+    ThreadPlacement& tp = get();
+    {
+        std::lock_guard<std::mutex> lock(tp.m_mutex);
+        if (tp.m_loaded) return;
+        tp.m_loaded = true;
+    }
+
+    auto broker = cci::cci_get_global_broker(cci::cci_originator("ThreadPlacement"));
+    for (auto cls : gs::sc_cci_children("thread_placement")) {
+        tp.load(broker, cls);
+    }
+    if (tp.is_configured(SYSTEMC)) {
+        tp.apply(SYSTEMC, "systemc");
+    }
+}
+
+bool gs::ThreadPlacement::parse_cpus(const std::string& list, std::vector<int>& cpus)
+{
+#if defined(__linux__)
+    const int max_cpus = CPU_SETSIZE;
+#else
+    const int max_cpus = 1024;
+#endif
+    std::stringstream ss(list);
+    std::string item;
+    while (std::getline(ss, item, ',')) {
+        if (item.empty()) continue;
+        auto dash = item.find('-');
+        try {
+            if (dash == std::string::npos) {
+                int c = std::stoi(item);
+                if (c < 0 || c >= max_cpus) return false;
+                cpus.push_back(c);
+            } else {
+                int first = std::stoi(item.substr(0, dash));
+                int last = std::stoi(item.substr(dash + 1));
+                if (first < 0 || first > last || last >= max_cpus) return false;
+                for (int c = first; c <= last; c++) cpus.push_back(c);
+            }
+        } catch (const std::exception&) {
+            return false;
+        }
+    }
+    return true;
+}
+
+void gs::ThreadPlacement::load(cci::cci_broker_handle broker, const std::string& cls)
+{
+    std::string base = "thread_placement." + cls;
+    policy p;
+
+    if (broker.has_preset_value(base + ".cpus")) {
+        std::string cpus = gs::cci_get<std::string>(broker, base + ".cpus");
+        if (!parse_cpus(cpus, p.cpus)) {
+            SCP_FATAL(())("Invalid CPU list '{}' for thread class '{}'", cpus, cls);
+        }
+    }
+    if (broker.has_preset_value(base + ".policy")) {
+        p.sched = gs::cci_get<std::string>(broker, base + ".policy");
+        p.has_sched = true;
+        if (p.sched != "other" && p.sched != "batch" && p.sched != "idle" && p.sched != "fifo" && p.sched != "rr") {
+            SCP_FATAL(())("Unknown scheduling policy '{}' for thread class '{}'", p.sched, cls);
+        }
+    }
+    if (broker.has_preset_value(base + ".priority")) {
+        p.priority = gs::cci_get<int>(broker, base + ".priority");
+    }
+    if (broker.has_preset_value(base + ".nice")) {
+        p.nice = gs::cci_get<int>(broker, base + ".nice");
+        p.has_nice = true;
+    }
+
+    std::lock_guard<std::mutex> lock(m_mutex);
+    m_policies[cls] = p;
+}
+
+bool gs::ThreadPlacement::is_configured(const std::string& cls) const
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+    return m_policies.find(cls) != m_policies.end();
+}
+
+void gs::ThreadPlacement::apply(const std::string& cls, const std::string& thread_name)
+{
+#ifndef _WIN32
+    std::string short_name = thread_name.substr(0, 15);
+#if defined(__APPLE__)
+    pthread_setname_np(short_name.c_str());
+#else
+    pthread_setname_np(pthread_self(), short_name.c_str());
+#endif
+#endif
+
+    policy p;
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        auto it = m_policies.find(cls);
+        if (it == m_policies.end()) return;
+        p = it->second;
+    }
+
+#if defined(__linux__)
+    if (!p.cpus.empty()) {
+        cpu_set_t set;
+        CPU_ZERO(&set);
+        for (int c : p.cpus) CPU_SET(c, &set);
+        int err = pthread_setaffinity_np(pthread_self(), sizeof(set), &set);
+        if (err) {
+            SCP_WARN(())("Unable to set CPU affinity of {} ({}): {}", thread_name, cls, std::strerror(err));
+        }
+    }
+
+    /* Only when configured: an explicit "other" resets a policy inherited from the creating thread */
+    if (p.has_sched) {
+        int sched = SCHED_OTHER;
+        if (p.sched == "batch")
+            sched = SCHED_BATCH;
+        else if (p.sched == "idle")
+            sched = SCHED_IDLE;
+        else if (p.sched == "fifo")
+            sched = SCHED_FIFO;
+        else if (p.sched == "rr")
+            sched = SCHED_RR;
+
+        struct sched_param param;
+        param.sched_priority = (sched == SCHED_FIFO || sched == SCHED_RR) ? p.priority : 0;
+        int err = pthread_setschedparam(pthread_self(), sched, &param);
+        if (err) {
+            SCP_WARN(())("Unable to set scheduling policy of {} ({}): {}", thread_name, cls, std::strerror(err));
+        }
+    }
+
+    if (p.has_nice) {
+        /* On Linux the nice value is per thread when addressed by tid. */
+        pid_t tid = syscall(SYS_gettid);
+        if (setpriority(PRIO_PROCESS, tid, p.nice) != 0) {
+            SCP_WARN(())("Unable to set nice value of {} ({}): {}", thread_name, cls, std::strerror(errno));
+        }
+    }
+
+    SCP_INFO(())("Placed thread {} in class {}", thread_name, cls);
+#else
+    if (!p.cpus.empty() || p.has_nice || p.has_sched) {
+        SCP_WARN(())("Thread placement is not supported on this host, ignoring class {}", cls);
+    }
+#endif
+}
@@ -0,0 +1,187 @@
+/*
+ * Copyright (c) 2024 Qualcomm Innovation Center, Inc. All Rights Reserved.
+ *
+ * SPDX-License-Identifier: BSD-3-Clause
+ */
+
+#include "trace_exporter.h"
+
+#include <cciutils.h>
+#include <uutils.h>
+
+#include <cerrno>
+#include <cstring>
+#include <iomanip>
+#include <sstream>
+
+#ifndef _WIN32
+#include <unistd.h>
+#endif
+
+void gs::TraceExporter::init()
+{
+    TraceExporter& te = get();
+    if (te.m_loaded) return;
+    te.m_loaded = true;
+    te.m_origin = clock::now();
+
+    auto broker = cci::cci_get_global_broker(cci::cci_originator("TraceExporter"));
+
+    if (!broker.has_preset_value("trace.file")) {
+        return;
+    }
+
+    std::string file = gs::cci_get<std::string>(broker, "trace.file");
+    std::FILE* f = std::fopen(file.c_str(), "w");
+    if (!f) {
+        SCP_WARN(())("Unable to open trace file {}: {}", file, std::strerror(errno));
+        return;
+    }
+    SCP_INFO(())("Writing the simulation timeline to {}", file);
+
+#ifndef _WIN32
+    te.m_pid = getpid();
+#endif
+    std::fputs("[\n", f);
+    te.m_file = f;
+    te.name_thread("systemc");
+    /* The process may end with _Exit() after a signal, without running the destructor */
+    SigHandler::get().register_on_exit_cb([&te]() { te.close(); });
+
+    if (broker.has_preset_value("trace.kernel") && gs::cci_get<bool>(broker, "trace.kernel")) {
+#ifdef SC_HAS_STAGE_CALLBACKS
+        te.m_step_start = clock::now();
+        sc_core::sc_register_stage_callback(te, sc_core::SC_POST_UPDATE | sc_core::SC_PRE_TIMESTEP);
+#else
+        SCP_WARN(())("trace.kernel needs SystemC 3.0, ignored");
+#endif
+    }
+}
+
+gs::TraceExporter::~TraceExporter() { close(); }
+
+void gs::TraceExporter::close()
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+    std::FILE* f = m_file.exchange(nullptr);
+    if (f) {
+        std::fputs("\n]\n", f);
+        std::fclose(f);
+    }
+}
+
+gs::TraceExporter& gs::TraceExporter::get()
+{
+    static TraceExporter instance;
+    return instance;
+}
+
+int gs::TraceExporter::tid()
+{
+    static thread_local int id = 0;
+    if (id == 0) id = m_next_tid++;
+    return id;
+}
+
+void gs::TraceExporter::write_event(const std::string& ev)
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+    std::FILE* f = m_file;
+    if (!f) return;
+    if (!m_first) std::fputs(",\n", f);
+    m_first = false;
+    std::fputs(ev.c_str(), f);
+}
+
+void gs::TraceExporter::put_string(std::ostream& os, const char* str)
+{
+    os << '"';
+    for (const char* c = str; *c; c++) {
+        unsigned char ch = *c;
+        if (ch == '"' || ch == '\\') {
+            os << '\\' << *c;
+        } else if (ch < 0x20) {
+            os << "\\u" << std::hex << std::setw(4) << std::setfill('0') << unsigned(ch) << std::dec;
+        } else {
+            os << *c;
+        }
+    }
+    os << '"';
+}
+
+void gs::TraceExporter::put_us(std::ostream& os, std::chrono::nanoseconds d)
+{
+    uint64_t ns = d.count() > 0 ? d.count() : 0;
+    os << ns / 1000 << '.' << std::setw(3) << std::setfill('0') << ns % 1000;
+}
+
+void gs::TraceExporter::complete(const char* cat, const char* name, clock::time_point start, clock::time_point end,
+                                 uint64_t sc_ns, const std::string& args)
+{
+    if (!enabled()) return;
+
+    std::stringstream ss;
+    ss << "{\"ph\":\"X\",\"cat\":";
+    put_string(ss, cat);
+    ss << ",\"name\":";
+    put_string(ss, name);
+    ss << ",\"pid\":" << m_pid << ",\"tid\":" << tid() << ",\"ts\":";
+    put_us(ss, start - m_origin);
+    ss << ",\"dur\":";
+    put_us(ss, end - start);
+    ss << ",\"args\":{\"sc_ns\":" << sc_ns;
+    if (!args.empty()) ss << "," << args;
+    ss << "}}";
+    write_event(ss.str());
+}
+
+void gs::TraceExporter::instant(const char* cat, const char* name, const std::string& args)
+{
+    if (!enabled()) return;
+
+    std::stringstream ss;
+    ss << "{\"ph\":\"i\",\"s\":\"t\",\"cat\":";
+    put_string(ss, cat);
+    ss << ",\"name\":";
+    put_string(ss, name);
+    ss << ",\"pid\":" << m_pid << ",\"tid\":" << tid() << ",\"ts\":";
+    put_us(ss, clock::now() - m_origin);
+    ss << ",\"args\":{\"sc_ns\":" << sc_now_ns();
+    if (!args.empty()) ss << "," << args;
+    ss << "}}";
+    write_event(ss.str());
+}
+
+void gs::TraceExporter::name_thread(const std::string& name)
+{
+    if (!enabled()) return;
+
+    std::stringstream ss;
+    ss << "{\"ph\":\"M\",\"name\":\"thread_name\",\"pid\":" << m_pid << ",\"tid\":" << tid()
+       << ",\"args\":{\"name\":";
+    put_string(ss, name.c_str());
+    ss << "}}";
+    write_event(ss.str());
+}
+
+void gs::TraceExporter::flush()
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+    std::FILE* f = m_file;
+    if (f) std::fflush(f);
+}
+
+#ifdef SC_HAS_STAGE_CALLBACKS
+/* SystemC thread: one interval per time step, an instant per delta cycle */
+void gs::TraceExporter::stage_callback(const sc_core::sc_stage& stage)
+{
+    if (stage == sc_core::SC_POST_UPDATE) {
+        instant("kernel", "delta");
+    } else {
+        clock::time_point now = clock::now();
+        complete("kernel", "time step", m_step_start, now, m_step_sc_ns);
+        m_step_start = now;
+        m_step_sc_ns = sc_now_ns();
+    }
+}
+#endif
@@ -0,0 +1,185 @@
+/*
+ * Copyright (c) 2024 Qualcomm Innovation Center, Inc. All Rights Reserved.
+ *
+ * SPDX-License-Identifier: BSD-3-Clause
+ */
+
+#ifndef QUANTUM_CONTROLLER_H
+#define QUANTUM_CONTROLLER_H
+
+#include <algorithm>
+#include <chrono>
+#include <string>
+#include <vector>
+
+#include <systemc>
+#include <tlm>
+#include <cci_configuration>
+#include <scp/report.h>
+
+#include <cciutils.h>
+#include <qkmultithread.h>
+#include <module_factory_registery.h>
+
+namespace gs {
+/**
+ * @brief quantum_controller: sc_module which adjusts the global TLM-2.0 quantum at run time
+ *
+ * Every interval_us of simulated time, the activity of each quantum keeper (one per vCPU) over the
+ * last interval is reviewed:
+ *   - If a vCPU interacted with the platform (accesses and interrupts) more than max_io_per_quantum
+ *     times per quantum, the quantum is halved: the interactions are too coarsely timed.
+ *   - Otherwise, if a vCPU spent more than max_wait_ratio of the time it was not idle waiting for
+ *     run budget, the quantum is doubled: synchronisation costs more than it buys.
+ * The quantum always stays within [min_quantum_ns, max_quantum_ns]; bounds which are not configured
+ * are widened to include the initial quantum. The current quantum is published in the quantum_ns
+ * parameter, and the number of changes in the adjustments parameter. While no vCPU is running, the
+ * controller waits for one to start again rather than keeping the simulation alive.
+ *
+ * @param interval_us : simulated time between two decisions.
+ * @param min_quantum_ns, max_quantum_ns : bounds of the quantum.
+ * @param max_io_per_quantum : accuracy constraint, see above.
+ * @param max_wait_ratio : sync overhead threshold, see above.
+ */
+SC_MODULE (quantum_controller) {
+    SCP_LOGGER();
+
+    cci::cci_param<uint64_t> p_interval_us;
+    cci::cci_param<uint64_t> p_min_quantum_ns;
+    cci::cci_param<uint64_t> p_max_quantum_ns;
+    cci::cci_param<double> p_max_io_per_quantum;
+    cci::cci_param<double> p_max_wait_ratio;
+    cci::cci_param<uint64_t> p_quantum_ns;
+    cci::cci_param<uint64_t> p_adjustments;
+
+private:
+    struct vcpu {
+        tlm_quantumkeeper_multithread* qk;
+        tlm_quantumkeeper_extended::sync_stats last;
+    };
+    std::vector<vcpu> m_vcpus;
+
+    bool vcpus_running() const
+    {
+        for (auto& v : m_vcpus) {
+            if (v.qk->status == tlm_quantumkeeper_multithread::RUNNING) return true;
+        }
+        return false;
+    }
+
+    /* Without a pending timed wait of ours, the kernel may end by starvation once all the vCPUs are idle */
+    void wait_vcpus_running()
+    {
+        sc_core::sc_event_or_list starts;
+        for (auto& v : m_vcpus) {
+            starts |= v.qk->get_tick_event();
+        }
+        while (!vcpus_running()) {
+            sc_core::wait(starts);
+        }
+    }
+
+    void control()
+    {
+        for (auto qk : find_all_tlm_quantumkeeper_multithread()) {
+            m_vcpus.push_back({ qk, qk->get_sync_stats() });
+        }
+        if (m_vcpus.empty()) {
+            SCP_WARN(())("No multithread quantum keeper found, the quantum will not be adjusted");
+            return;
+        }
+
+        auto last_rt = std::chrono::steady_clock::now();
+        for (;;) {
+            if (!vcpus_running()) {
+                wait_vcpus_running();
+                /* The idle period says nothing about the quantum, start a new interval */
+                last_rt = std::chrono::steady_clock::now();
+                for (auto& v : m_vcpus) {
+                    v.last = v.qk->get_sync_stats();
+                }
+            }
+
+            sc_core::sc_time interval(p_interval_us, sc_core::SC_US);
+            sc_core::wait(interval);
+
+            auto now_rt = std::chrono::steady_clock::now();
+            double wall_ns = std::chrono::duration_cast<std::chrono::nanoseconds>(now_rt - last_rt).count();
+            last_rt = now_rt;
+
+            double quantum_ns = tlm_quantumkeeper_extended::get_global_quantum().to_seconds() * 1e9;
+            double quanta = interval.to_seconds() * 1e9 / quantum_ns;
+            double max_io = 0, max_wait = 0;
+
+            for (auto& v : m_vcpus) {
+                auto s = v.qk->get_sync_stats();
+                double io = s.io - v.last.io;
+                double wait_ns = s.wait_ns - v.last.wait_ns;
+                double busy_ns = std::max(wall_ns - double(s.idle_ns - v.last.idle_ns), 1.0);
+                v.last = s;
+
+                max_io = std::max(max_io, io / quanta);
+                max_wait = std::max(max_wait, wait_ns / busy_ns);
+            }
+
+            uint64_t q = p_quantum_ns;
+            std::string reason;
+            if (max_io > p_max_io_per_quantum) {
+                q = q / 2;
+                reason = "interactions per quantum " + std::to_string(max_io);
+            } else if (max_wait > p_max_wait_ratio) {
+                q = q * 2;
+                reason = "sync wait ratio " + std::to_string(max_wait);
+            }
+            q = std::min(std::max(q, p_min_quantum_ns.get_value()), p_max_quantum_ns.get_value());
+
+            if (q != p_quantum_ns) {
+                SCP_INFO(())("Quantum {}ns -> {}ns ({})", p_quantum_ns.get_value(), q, reason);
+                set_quantum(q);
+                p_adjustments = p_adjustments + 1;
+            }
+        }
+    }
+
+    void set_quantum(uint64_t q)
+    {
+        p_quantum_ns = q;
+        tlm_quantumkeeper_extended::set_global_quantum(sc_core::sc_time(q, sc_core::SC_NS));
+    }
+
+public:
+    quantum_controller(const sc_core::sc_module_name& name)
+        : sc_module(name)
+        , p_interval_us("interval_us", 10000, "Simulated time between two quantum adjustments in microseconds")
+        , p_min_quantum_ns("min_quantum_ns", 10000, "Lower bound of the quantum in nanoseconds")
+        , p_max_quantum_ns("max_quantum_ns", 10000000, "Upper bound of the quantum in nanoseconds")
+        , p_max_io_per_quantum("max_io_per_quantum", 8, "Interactions per vCPU and quantum above which it shrinks")
+        , p_max_wait_ratio("max_wait_ratio", 0.1, "Share of time spent waiting for budget above which it grows")
+        , p_quantum_ns("quantum_ns", 0, "Current global quantum in nanoseconds (set by the controller)")
+        , p_adjustments("adjustments", 0, "Number of quantum changes made so far")
+    {
+        SCP_TRACE(())("quantum_controller constructor");
+        SC_HAS_PROCESS(quantum_controller);
+        SC_THREAD(control);
+    }
+
+    void start_of_simulation()
+    {
+        uint64_t q = uint64_t(tlm_quantumkeeper_extended::get_global_quantum().to_seconds() * 1e9);
+
+        if (q < p_min_quantum_ns && !p_min_quantum_ns.is_preset_value()) p_min_quantum_ns = q;
+        if (q > p_max_quantum_ns && !p_max_quantum_ns.is_preset_value()) p_max_quantum_ns = q;
+
+        uint64_t bounded = std::min(std::max(q, p_min_quantum_ns.get_value()), p_max_quantum_ns.get_value());
+        if (bounded != q) {
+            SCP_WARN(())("Global quantum {}ns out of [{}ns, {}ns], starting from {}ns", q, p_min_quantum_ns.get_value(),
+                         p_max_quantum_ns.get_value(), bounded);
+        }
+        set_quantum(bounded);
+    }
+};
+} // namespace gs
+
+extern "C" void module_register();
+
+#endif // QUANTUM_CONTROLLER_H
@@ -0,0 +1,11 @@
+/*
+ * Copyright (c) 2024 Qualcomm Innovation Center, Inc. All Rights Reserved.
+ *
+ * SPDX-License-Identifier: BSD-3-Clause
+ */
+
+#include <quantum_controller.h>
+
+typedef gs::quantum_controller quantum_controller;
+
+void module_register() { GSC_MODULE_REGISTER_C(quantum_controller); }
@@ -8,40 +8,103 @@
 #ifndef REALTIMLIMITER_H
 #define REALTIMLIMITER_H
 
+#include <algorithm>
+#include <atomic>
+#include <chrono>
 #include <thread>
 #include <mutex>
 #include <queue>
 #include <future>
 
+#if defined(__linux__)
+#include <cerrno>
+#include <ctime>
+#include <sys/prctl.h>
+#endif
+
 #include <systemc>
 #include <cci_configuration>
 #include <scp/report.h>
 
 #include <async_event.h>
+#include <thread_placement.h>
 #include <module_factory_registery.h>
 
 namespace gs {
 /**
  * @brief realtimelimiter: sc_module which suspends SystemC if SystemC time drifts ahead of realtime
- * @param @RTquantum_ms : realtime tick rate between checks.
+ * @param @RTquantum_ms : realtime tick rate between checks, may be below a millisecond.
  * @param @SCTimeout_ms : If SystemC time is behind by more than this value, then generate a fatal abort (0 disables)
+ * @param @slack_ms : how far SystemC time may run ahead of realtime before being suspended.
  *
+ * Ticks are paced against absolute deadlines on the monotonic clock, so that sleep latencies do not
+ * accumulate. How far SystemC time ran ahead of and behind realtime is published in the ahead_max_ms
+ * and behind_max_ms parameters, and reported at the end of the simulation.
  */
 SC_MODULE (realtimelimiter) {
     SCP_LOGGER();
     cci::cci_param<double> p_RTquantum_ms;
     cci::cci_param<double> p_SCTimeout_ms;
     cci::cci_param<double> p_MaxTime_ms;
+    cci::cci_param<double> p_slack_ms;
+    cci::cci_param<double> p_ahead_max_ms;
+    cci::cci_param<double> p_behind_max_ms;
+
+    using clock = std::chrono::steady_clock; // CLOCK_MONOTONIC
 
-    std::chrono::high_resolution_clock::time_point startRT;
+    clock::time_point startRT;
     sc_core::sc_time startSC;
-    sc_core::sc_time runto;
+    std::atomic<sc_dt::uint64> m_runto; // sc_time value, written by the ticker
     std::thread m_tick_thread;
-    bool running = false;
+    std::atomic<bool> running{ false };
     bool suspended = false;
     sc_core::sc_time suspend_at = sc_core::SC_ZERO_TIME;
     async_event tick;
 
+    /* Statistics */
+    double m_ahead_max_ms = 0;
+    double m_behind_max_ms = 0;
+    uint64_t m_suspensions = 0;
+    std::atomic<uint64_t> m_missed_ticks{ 0 };
+
+    sc_core::sc_time runto() const { return sc_core::sc_time::from_value(m_runto.load()); }
+
+    void set_runto(clock::time_point now)
+    {
+        auto elapsed = std::chrono::duration_cast<std::chrono::nanoseconds>(now - startRT);
+        sc_core::sc_time t = startSC + sc_core::sc_time(double(elapsed.count()), sc_core::SC_NS) +
+                             sc_core::sc_time(p_slack_ms, sc_core::SC_MS);
+        m_runto.store(t.value());
+    }
+
+    /* Record how far SystemC time is from realtime, positive when ahead */
+    void record_lag()
+    {
+        double rt_ms = std::chrono::duration<double, std::milli>(clock::now() - startRT).count();
+        double lead_ms = (sc_core::sc_time_stamp() - startSC).to_seconds() * 1000 - rt_ms;
+        if (lead_ms > m_ahead_max_ms) {
+            m_ahead_max_ms = lead_ms;
+            p_ahead_max_ms = lead_ms;
+        } else if (-lead_ms > m_behind_max_ms) {
+            m_behind_max_ms = -lead_ms;
+            p_behind_max_ms = -lead_ms;
+        }
+    }
+
+    static void sleep_until(clock::time_point t)
+    {
+#if defined(__linux__)
+        auto ns = std::chrono::duration_cast<std::chrono::nanoseconds>(t.time_since_epoch()).count();
+        struct timespec ts;
+        ts.tv_sec = ns / 1000000000;
+        ts.tv_nsec = ns % 1000000000;
+        while (clock_nanosleep(CLOCK_MONOTONIC, TIMER_ABSTIME, &ts, nullptr) == EINTR) {
+        }
+#else
+        std::this_thread::sleep_until(t);
+#endif
+    }
+
     void SCticker()
     {
         if (!running) {
@@ -58,19 +121,22 @@ SC_MODULE (realtimelimiter) {
         if (p_MaxTime_ms && sc_core::sc_time_stamp() > (sc_core::sc_time(p_MaxTime_ms, sc_core::SC_MS) + startSC)) {
             SCP_FATAL(())("Max timeout expired");
         }
+        record_lag();
 
-        if (sc_core::sc_time_stamp() >= runto) {
+        sc_core::sc_time limit = runto();
+        if (sc_core::sc_time_stamp() >= limit) {
             SCP_TRACE(())("Suspending");
             tick.async_attach_suspending();
             sc_core::sc_suspend_all(); // Dont starve while we're waiting
                                        // for realtime.
             suspend_at = sc_core::sc_time_stamp();
             suspended = true;
+            m_suspensions++;
         } else {
             SCP_TRACE(())("Resuming");
             suspended = false;
             // lets go with +=1/2 a RTquantum
-            tick.notify((runto + sc_core::sc_time(p_RTquantum_ms, sc_core::SC_MS) / 2) - sc_core::sc_time_stamp());
+            tick.notify((limit + sc_core::sc_time(p_RTquantum_ms, sc_core::SC_MS) / 2) - sc_core::sc_time_stamp());
             tick.async_detach_suspending(); // We could even starve !
             sc_core::sc_unsuspend_all();
         }
@@ -78,29 +144,44 @@ SC_MODULE (realtimelimiter) {
 
     void RTticker()
     {
+        ThreadPlacement::get().apply(ThreadPlacement::TIMER, "rt-ticker");
+#if defined(__linux__)
+        prctl(PR_SET_TIMERSLACK, 1UL); // otherwise wake ups may be up to 50us late
+#endif
+        const auto min_period = std::chrono::nanoseconds(1000);
+        const auto stall_warn_period = std::chrono::seconds(1); // shorter stalls are not reported
         sc_core::sc_time last = sc_core::SC_ZERO_TIME;
+        clock::time_point last_change = startRT;
+        clock::time_point next = startRT;
+
         while (running) {
-            std::this_thread::sleep_for(std::chrono::milliseconds(p_RTquantum_ms));
-
-            runto = sc_core::sc_time(std::chrono::duration_cast<std::chrono::microseconds>(
-                                         std::chrono::high_resolution_clock::now() - startRT)
-                                         .count(),
-                                     sc_core::SC_US) +
-                    startSC;
-            if (last > sc_core::SC_ZERO_TIME && sc_core::sc_time_stamp() == last) {
-                p_RTquantum_ms.set_value(p_RTquantum_ms.get_value() + 100);
+            auto period = std::max(std::chrono::nanoseconds(int64_t(p_RTquantum_ms * 1e6)), min_period);
+            next += period;
+            sleep_until(next);
+
+            clock::time_point now = clock::now();
+            if (now - next > period) {
+                /* Late by more than a tick (host preemption), do not try to catch up */
+                m_missed_ticks += (now - next) / period;
+                next = now;
+            }
+            set_runto(now);
+
+            sc_core::sc_time sc_now = sc_core::sc_time_stamp();
+            if (sc_now != last) {
+                last = sc_now;
+                last_change = now;
+            } else if (now - last_change >= stall_warn_period) {
+                last_change = now;
                 SCP_WARN(())
-                ("Stalled ? (runto is {}s ahead, systemc time has not changed, new limit {}ms {}s)",
-                 (runto - sc_core::sc_time_stamp()).to_seconds(), p_RTquantum_ms.get_value(), runto.to_seconds());
+                ("Stalled ? (runto is {}s ahead, systemc time has not changed for {}s)",
+                 (runto() - sc_now).to_seconds(), stall_warn_period.count());
                 /* Only check for exsessive runto's if we're stalled */
-                if (p_SCTimeout_ms &&
-                    (runto > sc_core::sc_time_stamp() + sc_core::sc_time(p_SCTimeout_ms, sc_core::SC_MS))) {
+                if (p_SCTimeout_ms && (runto() > sc_now + sc_core::sc_time(p_SCTimeout_ms, sc_core::SC_MS))) {
                     SCP_FATAL(())
-                    ("Requested runto is {}s ahead (SCTimeout_ms set to {}s)",
-                     (runto - sc_core::sc_time_stamp()).to_seconds(), p_SCTimeout_ms / 1000);
+                    ("Requested runto is {}s ahead (SCTimeout_ms set to {}s)", (runto() - sc_now).to_seconds(),
+                     p_SCTimeout_ms / 1000);
                 }
-            } else {
-                last = sc_core::sc_time_stamp();
             }
 
             tick.notify();
@@ -115,9 +196,11 @@ public:
 
         running = true;
 
-        startRT = std::chrono::high_resolution_clock::now();
+        startRT = clock::now();
         startSC = sc_core::sc_time_stamp();
-        runto = sc_core::sc_time(p_RTquantum_ms, sc_core::SC_MS) + sc_core::sc_time_stamp();
+        m_runto.store((sc_core::sc_time(p_RTquantum_ms, sc_core::SC_MS) + sc_core::sc_time(p_slack_ms, sc_core::SC_MS) +
+                       sc_core::sc_time_stamp())
+                          .value());
         tick.notify(sc_core::sc_time(p_RTquantum_ms, sc_core::SC_MS));
 
         m_tick_thread = std::thread(&realtimelimiter::RTticker, this);
@@ -136,6 +219,10 @@ public:
         , p_RTquantum_ms("RTquantum_ms", 100, "Real time quantum in milliseconds")
         , p_SCTimeout_ms("SCTimeout_ms", 0, "Timeout for SystemC in milliseconds")
         , p_MaxTime_ms("MaxTime_ms", 0, "Maximum run time in ms (0=no limit)")
+        , p_slack_ms("slack_ms", 0, "How far SystemC time may run ahead of real time in milliseconds")
+        , p_ahead_max_ms("ahead_max_ms", 0, "Furthest SystemC time ran ahead of real time in milliseconds (statistic)")
+        , p_behind_max_ms("behind_max_ms", 0, "Furthest SystemC time fell behind real time in milliseconds (statistic)")
+        , m_runto(0)
         , tick(false) // handle attach manually
     {
         SCP_TRACE(())("realtimelimiter constructor");
@@ -148,7 +235,13 @@ public:
         }
     }
 
-    void end_of_simulation() { disable(); }
+    void end_of_simulation()
+    {
+        disable();
+        SCP_INFO(())
+        ("SystemC time was at most {}ms ahead and {}ms behind real time, {} suspensions, {} missed ticks",
+         m_ahead_max_ms, m_behind_max_ms, m_suspensions, m_missed_ticks.load());
+    }
 };
 } // namespace gs
 
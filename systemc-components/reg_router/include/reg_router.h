@@ -314,6 +314,14 @@ public:
 
     ~reg_router() = default;
 
+    bool is_initiator_bound(const tlm::tlm_bw_transport_if<>* bw) override
+    {
+        for (unsigned int i = 0; i < target_socket.size(); i++) {
+            if (target_socket[i] == bw) return true;
+        }
+        return false;
+    }
+
 public:
     // make the sockets public for binding
     initiator_socket_type initiator_socket;
@@ -8,6 +8,7 @@
 #ifndef _GREENSOCS_BASE_COMPONENTS_ROUTER_H
 #define _GREENSOCS_BASE_COMPONENTS_ROUTER_H
 
+#include <algorithm>
 #include <cinttypes>
 #include <vector>
 
@@ -30,6 +31,7 @@
 #include <tlm_utils/multi_passthrough_target_socket.h>
 
 #include <tlm-extensions/pathid_extension.h>
+#include <tlm-extensions/thread_safe_extension.h>
 #include <cciutils.h>
 #include <router_if.h>
 #include <module_factory_registery.h>
@@ -192,6 +194,31 @@ private:
         }
     }
 
+    /*
+     * Report to the initiator, if it asked for it, the range of a target that
+     * can be accessed from any thread, in this router address space.
+     */
+    void annotate_thread_safe(target_info* ti, tlm::tlm_generic_payload& trans)
+    {
+        ThreadSafeExtension* ext = nullptr;
+        trans.get_extension(ext);
+        if (!ext) return;
+
+        sc_dt::uint64 ti_end = ti->address + ti->size - 1;
+        if (ext->is_set()) {
+            /* Set by the target (or a chained router) in its own address space */
+            sc_dt::uint64 start = ext->get_start();
+            sc_dt::uint64 end = ext->get_end();
+            if (ti->use_offset) {
+                start += ti->address;
+                end += ti->address;
+            }
+            ext->set(std::max(start, ti->address), std::min(end, ti_end));
+        } else if (ti->thread_safe) {
+            ext->set(ti->address, ti_end);
+        }
+    }
+
     void b_transport(int id, tlm::tlm_generic_payload& trans, sc_core::sc_time& delay)
     {
         bool found = false;
@@ -217,6 +244,7 @@ private:
             if (ti->use_offset) trans.set_address(addr - ti->address);
             initiator_socket[ti->index]->b_transport(trans, delay);
             if (ti->use_offset) trans.set_address(addr);
+            annotate_thread_safe(ti, trans);
         }
         if (!ti->chained) SCP_TRACE((D[ti->index]), ti->name) << "b_transport returned : " << txn_tostring(ti, trans);
         unstamp_txn(id, trans);
@@ -344,6 +372,25 @@ private:
         return nullptr;
     }
 
+public:
+    std::vector<target_info> get_address_map() override
+    {
+        lazy_initialize();
+        std::vector<target_info> map;
+        for (auto ti : targets) {
+            if (ti->size) map.push_back(*ti);
+        }
+        return map;
+    }
+
+    bool is_initiator_bound(const tlm::tlm_bw_transport_if<>* bw) override
+    {
+        for (unsigned int i = 0; i < target_socket.size(); i++) {
+            if (target_socket[i] == bw) return true;
+        }
+        return false;
+    }
+
 protected:
     virtual void before_end_of_elaboration()
     {
@@ -385,6 +432,7 @@ private:
             ti.use_offset = gs::cci_get_d<bool>(m_broker, name + ".relative_addresses", true);
             ti.chained = gs::cci_get_d<bool>(m_broker, name + ".chained", false);
             ti.priority = gs::cci_get_d<uint32_t>(m_broker, name + ".priority", 0);
+            ti.thread_safe = gs::cci_get_d<bool>(m_broker, name + ".thread_safe", false);
 
             SCP_INFO((D[ti.index]), ti.name)
                 << "Address map " << ti.name + " at"
@@ -19,6 +19,8 @@
 #include <tests/initiator-tester.h>
 #include <tests/test-bench.h>
 
+#include <vector>
+
 #if defined(__APPLE__)
 #include <mach-o/dyld.h>
 #endif
@@ -89,6 +91,51 @@ public:
         ASSERT_EQ(v1, v2);
     }
 
+    void do_posted_write_read_check(uint64_t addr, int count)
+    {
+        // more writes than can be in flight, a read must see all of them, in order
+        for (int i = 0; i < count; i++) {
+            uint32_t v = 0xc0de0000 + i;
+            ASSERT_EQ(m_initiator.do_write(addr + i * sizeof(v), v), tlm::TLM_OK_RESPONSE);
+        }
+        for (int i = 0; i < count; i++) {
+            uint32_t v = 0xc0de0000 + i;
+            ASSERT_EQ(m_initiator.do_write(addr, v), tlm::TLM_OK_RESPONSE);
+        }
+        uint32_t v;
+        ASSERT_EQ(m_initiator.do_read(addr, v), tlm::TLM_OK_RESPONSE);
+        ASSERT_EQ(v, 0xc0de0000 + count - 1);
+        for (int i = 1; i < count; i++) {
+            ASSERT_EQ(m_initiator.do_read(addr + i * sizeof(v), v), tlm::TLM_OK_RESPONSE);
+            ASSERT_EQ(v, 0xc0de0000 + i);
+        }
+    }
+    void do_large_write_read_check(uint64_t addr, size_t len, bool debug = false)
+    {
+        std::vector<uint8_t> d1(len), d2(len, 0);
+        for (size_t i = 0; i < len; i++) {
+            d1[i] = uint8_t(i * 7 + 1);
+        }
+        ASSERT_EQ(m_initiator.do_write_with_ptr(addr, d1.data(), len, debug), tlm::TLM_OK_RESPONSE);
+        ASSERT_EQ(m_initiator.do_read_with_ptr(addr, d2.data(), len, debug), tlm::TLM_OK_RESPONSE);
+        ASSERT_EQ(d1, d2);
+    }
+    void do_dmi_coherency_check(uint64_t addr)
+    {
+        // accesses through the bridge and through the DMI pointer see each other
+        uint64_t v1 = 0x5a5a00005a5a0000, v2;
+        ASSERT_EQ(m_initiator.do_write(addr, v1), tlm::TLM_OK_RESPONSE);
+        ASSERT_EQ(m_initiator.do_read(addr, v2), tlm::TLM_OK_RESPONSE);
+        ASSERT_EQ(v1, v2);
+        ASSERT_TRUE(m_initiator.do_dmi_request(addr));
+        tlm::tlm_dmi dmi = m_initiator.get_last_dmi_data();
+        uint64_t* d = (uint64_t*)(dmi.get_dmi_ptr() + (addr - dmi.get_start_address()));
+        ASSERT_EQ(d[0], v1);
+        d[0] = ~v1;
+        ASSERT_EQ(m_initiator.do_read(addr, v2), tlm::TLM_OK_RESPONSE);
+        ASSERT_EQ(v2, ~v1);
+    }
+
 public:
     RemotePassTest(const sc_core::sc_module_name& n)
         : TestBench(n)
@@ -117,4 +164,6 @@ public:
         m_pass.initiator_sockets[0].bind(m_router.target_socket);
     }
     virtual ~RemotePassTest() {}
+
+    const gs::PassRPC<>& get_pass() const { return m_pass; }
 };
@@ -0,0 +1,84 @@
+/*
+ * Copyright (c) 2024 Qualcomm Innovation Center, Inc. All Rights Reserved.
+ *
+ * SPDX-License-Identifier: BSD-3-Clause
+ */
+
+#include "remote-bench.h"
+#include <cci/utils/broker.h>
+#include <scp/report.h>
+
+// Same bench as remote-tests, over the shared memory transport with the DMI cache and posted writes
+TEST_BENCH(RemotePassTest, shmem_bench)
+{
+    SCP_INFO(SCMOD) << "Load and store";
+    uint64_t calls = get_pass().get_shm_calls();
+    for (int i = 0; i < 10; i++) {
+        do_write_read_check(0x11000);
+        do_write_read_check(0x22000);
+        do_write_read_check_larger(0x22000 + (i * 8));
+    }
+    // the remote memories were reached through the shared memory channel, not rpclib
+    EXPECT_GT(get_pass().get_shm_calls(), calls);
+    SCP_INFO(SCMOD) << "Posted writes";
+    uint64_t posts = get_pass().get_shm_posts();
+    do_posted_write_read_check(0x40000, 200);
+    EXPECT_GT(get_pass().get_shm_posts(), posts);
+    SCP_INFO(SCMOD) << "Staged transactions";
+    do_large_write_read_check(0x41000, 0x2000);
+    do_large_write_read_check(0x44000, 0x2000, true);
+    SCP_INFO(SCMOD) << "Larger than the staging area";
+    do_large_write_read_check(0x48000, 0x18000);
+    SCP_INFO(SCMOD) << "DMI cache";
+    uint64_t hits = get_pass().get_dmi_cache_hits();
+    for (int i = 0; i < 10; i++) {
+        do_dmi_coherency_check(0x23000 + (i * 8));
+    }
+    // the accesses after the first one of the region were served locally
+    EXPECT_GT(get_pass().get_dmi_cache_hits(), hits);
+    SCP_INFO(SCMOD) << "Looks OK";
+    sc_core::sc_stop();
+}
+
+int sc_main(int argc, char* argv[])
+{
+    gs::ConfigurableBroker m_broker({
+        { "shmem_bench.mem1.target_socket.address", cci::cci_value(0x11000) },
+        { "shmem_bench.mem1.target_socket.size", cci::cci_value(0x1000) },
+        { "shmem_bench.pass.mem2.target_socket.address", cci::cci_value(0x40000) },
+        { "shmem_bench.pass.mem2.target_socket.size", cci::cci_value(0x20000) },
+        { "shmem_bench.pass.mem3.target_socket.address", cci::cci_value(0x22000) },
+        { "shmem_bench.pass.mem3.target_socket.size", cci::cci_value(0x2000) },
+        { "shmem_bench.local.target_socket.address", cci::cci_value(0x11000) },
+        { "shmem_bench.local.target_socket.size", cci::cci_value(0x1000) },
+
+        { "shmem_bench.mem1.log_level", cci::cci_value(4) },
+        { "shmem_bench.pass.mem2.log_level", cci::cci_value(4) },
+        { "shmem_bench.pass.mem3.log_level", cci::cci_value(4) },
+
+        { "shmem_bench.mem1.shared_memory", cci::cci_value(true) },
+        { "shmem_bench.pass.mem2.shared_memory", cci::cci_value(true) },
+        { "shmem_bench.pass.mem3.shared_memory", cci::cci_value(true) },
+
+        { "shmem_bench.pass.tlm_initiator_ports_num", cci::cci_value(1) },
+        { "shmem_bench.pass.tlm_target_ports_num", cci::cci_value(2) },
+
+        { "shmem_bench.pass.remote_pass.tlm_initiator_ports_num", cci::cci_value(2) },
+        { "shmem_bench.pass.remote_pass.tlm_target_ports_num", cci::cci_value(1) },
+
+        { "shmem_bench.pass.shmem_transport", cci::cci_value(true) },
+        { "shmem_bench.pass.remote_pass.shmem_transport", cci::cci_value(true) },
+        { "shmem_bench.pass.shmem_staging_size", cci::cci_value(0x10000) },
+        { "shmem_bench.pass.dmi_cache", cci::cci_value(true) },
+        { "shmem_bench.pass.posted_writes.0.address", cci::cci_value(0x40000) },
+        { "shmem_bench.pass.posted_writes.0.size", cci::cci_value(0x1000) },
+
+        { "shmem_bench.pass.target_socket_0.address", cci::cci_value(0x20000) },
+        { "shmem_bench.pass.target_socket_0.size", cci::cci_value(0x40000) },
+        { "shmem_bench.pass.target_socket_0.relative_addresses", cci::cci_value(false) },
+        { "shmem_bench.pass.exec_path", cci::cci_value(getexepath() + "-remote") },
+    });
+
+    ::testing::InitGoogleTest(&argc, argv);
+    return RUN_ALL_TESTS();
+}
@@ -16,6 +16,7 @@
 
 #include <tlm_utils/simple_initiator_socket.h>
 #include <tlm_utils/simple_target_socket.h>
+#include <algorithm>
 #include <vector>
 
 static constexpr size_t NB_TARGETS = 4;
@@ -36,6 +37,7 @@ private:
     gs::router<> m_router;
     std::vector<TargetTester*> m_target;
     gs::pass<> m_pass;
+    TargetTester m_empty_target; // bound without an address range
 
     bool m_overlap_address = false;
     bool m_overlap_size = false;
@@ -224,6 +226,20 @@ protected:
         }
     }
 
+    void do_address_map_check()
+    {
+        // one entry per target with an address range
+        std::vector<gs::router<>::target_info> map = m_router.get_address_map();
+        ASSERT_EQ(map.size(), NB_TARGETS);
+        for (int i = 0; i < NB_TARGETS; i++) {
+            auto it = std::find_if(map.begin(), map.end(), [&](const gs::router<>::target_info& ti) {
+                return ti.address == address[i];
+            });
+            ASSERT_NE(it, map.end());
+            ASSERT_EQ(it->size, size[i]);
+        }
+    }
+
     void do_bad_dmi_request_and_check(int id, uint64_t addr)
     {
         overlap(id);
@@ -241,7 +257,12 @@ protected:
 
 public:
     RouterTestBenchSimple(const sc_core::sc_module_name& n)
-        : TestBench(n), m_initiator("initiator"), m_router("router"), m_pass("pass"), m_target()
+        : TestBench(n)
+        , m_initiator("initiator")
+        , m_router("router")
+        , m_pass("pass")
+        , m_target()
+        , m_empty_target("Target_empty", 1)
     {
         int id = 0;
 
@@ -281,6 +302,7 @@ public:
         for (int i = 0; i < NB_TARGETS; i++) {
             m_router.add_target(m_target[i]->socket, address[i], size[i]);
         }
+        m_router.add_target(m_empty_target.socket, 0x1000, 0);
     }
 
     virtual ~RouterTestBenchSimple()
@@ -111,6 +111,9 @@ TEST_BENCH(RouterTestBenchSimple, SimpleDmiOverlap)
     do_good_dmi_request_and_check(3, address[3], address[3], target_size[3] - 1);
 }
 
+// The address map lists the targets with an address range only
+TEST_BENCH(RouterTestBenchSimple, AddressMap) { do_address_map_check(); }
+
 int sc_main(int argc, char* argv[])
 {
     cci_utils::consuming_broker broker("global_broker");
@@ -0,0 +1,97 @@
+/*
+ * Copyright (c) 2024 Qualcomm Innovation Center, Inc. All Rights Reserved.
+ *
+ * SPDX-License-Identifier: BSD-3-Clause
+ */
+
+#include <gtest/gtest.h>
+#include <gmock/gmock.h>
+#include "async_event.h"
+
+#include <thread>
+
+gs::async_event* ev = nullptr;
+int triggers = 0;
+sc_core::sc_time last_trigger;
+
+void on_event()
+{
+    triggers++;
+    last_trigger = sc_core::sc_time_stamp();
+}
+
+// run the deltas of the current time
+void settle()
+{
+    do {
+        sc_core::sc_start(sc_core::SC_ZERO_TIME);
+    } while (sc_core::sc_pending_activity_at_current_time());
+}
+
+int sc_main(int argc, char** argv)
+{
+    ev = new gs::async_event(false); // let the simulation starve between tests
+    sc_core::sc_spawn_options opts;
+    opts.spawn_method();
+    opts.set_sensitivity(ev);
+    opts.dont_initialize();
+    sc_core::sc_spawn(&on_event, "on_event", &opts);
+
+    testing::InitGoogleTest(&argc, argv);
+    int status = RUN_ALL_TESTS();
+    return status;
+}
+
+TEST(async_event, coalesced)
+{
+    // notifies from another thread before the kernel gets to them trigger the event once
+    triggers = 0;
+    uint64_t notifies = ev->get_async_notifies();
+    uint64_t updates = ev->get_async_updates();
+    std::thread t([]() {
+        for (int i = 0; i < 1000; i++) {
+            ev->async_notify();
+        }
+    });
+    t.join();
+    EXPECT_EQ(ev->get_async_notifies() - notifies, 1000u);
+    EXPECT_EQ(ev->get_async_updates() - updates, 1u);
+    settle();
+    EXPECT_EQ(triggers, 1);
+
+    // once handled, the next notify reaches the kernel again
+    std::thread t2([]() { ev->async_notify(); });
+    t2.join();
+    EXPECT_EQ(ev->get_async_updates() - updates, 2u);
+    settle();
+    EXPECT_EQ(triggers, 2);
+}
+
+TEST(async_event, earliest_delay)
+{
+    // coalesced notifies keep the earliest of the delays
+    triggers = 0;
+    sc_core::sc_time start = sc_core::sc_time_stamp();
+    std::thread t([]() {
+        ev->notify(sc_core::sc_time(10, sc_core::SC_US));
+        ev->notify(sc_core::sc_time(3, sc_core::SC_US));
+        ev->notify(sc_core::sc_time(7, sc_core::SC_US));
+    });
+    t.join();
+    sc_core::sc_start(sc_core::sc_time(20, sc_core::SC_US));
+    EXPECT_EQ(triggers, 1);
+    EXPECT_EQ(last_trigger, start + sc_core::sc_time(3, sc_core::SC_US));
+}
+
+TEST(async_event, same_thread)
+{
+    // from the SystemC thread, a notify is a plain event notification
+    triggers = 0;
+    uint64_t notifies = ev->get_async_notifies();
+    sc_core::sc_time start = sc_core::sc_time_stamp();
+    ev->notify(sc_core::sc_time(1, sc_core::SC_US));
+    EXPECT_EQ(ev->get_async_notifies(), notifies);
+    sc_core::sc_start(sc_core::sc_time(2, sc_core::SC_US));
+    EXPECT_EQ(triggers, 1);
+    EXPECT_EQ(last_trigger, start + sc_core::sc_time(1, sc_core::SC_US));
+}
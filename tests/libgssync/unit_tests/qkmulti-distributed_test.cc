@@ -0,0 +1,69 @@
+/*
+ * Copyright (c) 2024 Qualcomm Innovation Center, Inc. All Rights Reserved.
+ *
+ * SPDX-License-Identifier: BSD-3-Clause
+ */
+
+#include <gtest/gtest.h>
+#include <gmock/gmock.h>
+#include "qkmulti-distributed.h"
+
+#include <limits>
+#include <string>
+#include <unistd.h>
+
+#ifdef SC_HAS_STAGE_CALLBACKS
+int sc_main(int argc, char** argv)
+{
+    sc_core::sc_time quantum(1, sc_core::SC_MS);
+    tlm_utils::tlm_quantumkeeper::set_global_quantum(quantum);
+    testing::InitGoogleTest(&argc, argv);
+    int status = RUN_ALL_TESTS();
+    return status;
+}
+
+/* The other process is played by the joining side of the channel, in this process */
+TEST(qkmulti_distributed, follows_peer)
+{
+    std::string name = "/gsqkdist" + std::to_string(getpid());
+    gs::RpcShmemChannel local(name, true);
+    gs::RpcShmemChannel peer(name, false);
+    ASSERT_TRUE(local.is_open());
+    ASSERT_TRUE(peer.is_open());
+
+    sc_core::sc_time quantum(1, sc_core::SC_MS);
+    auto* qk = new gs::tlm_quantumkeeper_multi_distributed;
+    // not connected, nothing to hold SystemC back
+    EXPECT_EQ(qk->get_current_time(), sc_core::sc_max_time());
+
+    qk->attach(&local);
+    qk->start();
+    // our time was published, 0 ps
+    EXPECT_EQ(peer.peer_time(), 1u);
+    // the other side did not publish yet
+    EXPECT_EQ(qk->get_current_time(), sc_core::sc_max_time());
+
+    // the local time is the time of the other side plus a quantum
+    peer.publish_time(5000000 + 1);
+    EXPECT_EQ(qk->get_current_time(), sc_core::sc_time(5, sc_core::SC_US) + quantum);
+    peer.publish_time(7000000 + 1);
+    EXPECT_EQ(qk->get_current_time(), sc_core::sc_time(7, sc_core::SC_US) + quantum);
+
+    // once stopped, the other side is told never to wait for us
+    qk->stop();
+    EXPECT_EQ(peer.peer_time(), std::numeric_limits<uint64_t>::max());
+
+    // and a stopped peer does not hold us back either
+    peer.publish_time(std::numeric_limits<uint64_t>::max());
+    EXPECT_EQ(qk->get_current_time(), sc_core::sc_max_time());
+    delete qk;
+}
+#else
+int sc_main(int argc, char** argv)
+{
+    testing::InitGoogleTest(&argc, argv);
+    return RUN_ALL_TESTS();
+}
+
+TEST(qkmulti_distributed, needs_systemc_3) { GTEST_SKIP() << "multithread-distributed needs SystemC 3.0"; }
+#endif
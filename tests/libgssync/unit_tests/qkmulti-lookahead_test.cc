@@ -0,0 +1,98 @@
+/*
+ * Copyright (c) 2024 Qualcomm Innovation Center, Inc. All Rights Reserved.
+ *
+ * SPDX-License-Identifier: BSD-3-Clause
+ */
+
+#include <gtest/gtest.h>
+#include <gmock/gmock.h>
+#include "qkmulti-lookahead.h"
+
+#ifdef SC_HAS_STAGE_CALLBACKS
+gs::tlm_quantumkeeper_extended* qk = nullptr;
+sc_core::sc_event* ev = nullptr;
+
+bool done;
+void bounded_by_event()
+{
+    // the next SystemC event comes before the end of the quantum
+    sc_core::sc_time budget = qk->time_to_sync();
+    EXPECT_EQ(budget, sc_core::sc_time(300, sc_core::SC_US));
+    qk->inc(budget);
+    EXPECT_TRUE(qk->need_sync());
+    qk->sync();
+    // SystemC went past the event before handing out more budget
+    EXPECT_GE(sc_core::sc_time_stamp(), sc_core::sc_time(300, sc_core::SC_US));
+    EXPECT_NE(qk->time_to_sync(), sc_core::SC_ZERO_TIME);
+    done = true;
+    qk->stop();
+}
+
+void bounded_by_quantum()
+{
+    // no other event pending, the quantum bounds the budget
+    sc_core::sc_time quantum(1, sc_core::SC_MS);
+    sc_core::sc_time budget = qk->time_to_sync();
+    EXPECT_GT(budget, sc_core::SC_ZERO_TIME);
+    EXPECT_LE(budget, quantum);
+    for (int i = 0; i < 10; i++) {
+        qk->inc(qk->time_to_sync());
+        qk->sync();
+        EXPECT_NE(qk->time_to_sync(), sc_core::SC_ZERO_TIME);
+    }
+    // never more than one quantum ahead of SystemC
+    EXPECT_LE(qk->get_current_time(), sc_core::sc_time_stamp() + quantum);
+    done = true;
+    qk->stop();
+}
+
+void run(void (*fn)())
+{
+    done = false;
+    qk->reset();
+    qk->start();
+    // let the deltas settle, so that the kernel publishes its next event
+    sc_core::sc_start(sc_core::SC_ZERO_TIME);
+    std::thread t1(fn);
+    while (sc_core::sc_pending_activity() || !done) {
+        if (sc_core::sc_pending_activity()) {
+            sc_core::sc_time t = sc_core::sc_time_to_pending_activity();
+            sc_start(t);
+        }
+    }
+    t1.join();
+}
+
+int sc_main(int argc, char** argv)
+{
+    qk = new gs::tlm_quantumkeeper_multi_lookahead;
+    ev = new sc_core::sc_event("ev");
+    sc_core::sc_time quantum(1, sc_core::SC_MS);
+    tlm_utils::tlm_quantumkeeper::set_global_quantum(quantum);
+    testing::InitGoogleTest(&argc, argv);
+    int status = RUN_ALL_TESTS();
+    return status;
+}
+
+TEST(qkmulti_lookahead, bounded_by_event)
+{
+    ev->notify(sc_core::sc_time(300, sc_core::SC_US));
+    run(bounded_by_event);
+}
+
+TEST(qkmulti_lookahead, bounded_by_quantum) { run(bounded_by_quantum); }
+
+TEST(qkmulti_lookahead, stopped)
+{
+    // a stopped quantum keeper hands out no budget
+    EXPECT_EQ(qk->time_to_sync(), sc_core::SC_ZERO_TIME);
+}
+#else
+int sc_main(int argc, char** argv)
+{
+    testing::InitGoogleTest(&argc, argv);
+    return RUN_ALL_TESTS();
+}
+
+TEST(qkmulti_lookahead, needs_systemc_3) { GTEST_SKIP() << "multithread-lookahead needs SystemC 3.0"; }
+#endif
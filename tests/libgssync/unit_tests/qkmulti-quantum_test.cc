@@ -61,6 +61,20 @@ void finished_quantum()
     qk->stop();
 }
 
+// whole quanta: each sync() parks until SystemC reaches the local time
+void many_syncs()
+{
+    sc_core::sc_time quantum(1, sc_core::SC_MS);
+    for (int i = 0; i < 20; i++) {
+        qk->inc(qk->time_to_sync());
+        EXPECT_TRUE(qk->need_sync());
+        qk->sync();
+        EXPECT_FALSE(qk->need_sync());
+    }
+    done = true;
+    qk->stop();
+}
+
 int sc_main(int argc, char** argv)
 {
     qk = new gs::tlm_quantumkeeper_multi_quantum;
@@ -101,3 +115,21 @@ TEST(qkmulti_quantum, finished_quantum)
     }
     t1.join();
 }
+
+TEST(qkmulti_quantum, parked_sync)
+{
+    done = false;
+    qk->start();
+    qk->reset();
+    std::thread t1(many_syncs);
+    while (sc_core::sc_pending_activity() || !done) {
+        if (sc_core::sc_pending_activity()) {
+            sc_core::sc_time t = sc_core::sc_time_to_pending_activity();
+            sc_start(t);
+        }
+    }
+    t1.join();
+    // never more than one quantum ahead of SystemC
+    sc_core::sc_time quantum(1, sc_core::SC_MS);
+    EXPECT_GE(sc_core::sc_time_stamp() + quantum, qk->get_current_time());
+}
@@ -61,6 +61,19 @@ void finished_quantum()
     qk->stop();
 }
 
+// many short quanta, each sync() either has budget left or parks until SystemC catches up
+void many_syncs()
+{
+    sc_core::sc_time quantum(1, sc_core::SC_MS);
+    for (int i = 0; i < 100; i++) {
+        qk->inc(quantum / 4);
+        qk->sync();
+        EXPECT_NE(qk->time_to_sync(), sc_core::SC_ZERO_TIME);
+    }
+    done = true;
+    qk->stop();
+}
+
 int sc_main(int argc, char** argv)
 {
     scp::init_logging(scp::LogConfig()
@@ -108,3 +121,53 @@ TEST(qkmultithread, finished_quantum)
     }
     t1.join();
 }
+
+TEST(qkmultithread, parked_sync)
+{
+    done = false;
+    qk->start();
+    qk->reset();
+    sc_core::sc_time start = qk->get_current_time();
+    std::thread t1(many_syncs);
+    while (sc_core::sc_pending_activity() || !done) {
+        if (sc_core::sc_pending_activity()) {
+            sc_core::sc_time t = sc_core::sc_time_to_pending_activity();
+            sc_start(t);
+        }
+    }
+    t1.join();
+    sc_core::sc_time quantum(1, sc_core::SC_MS);
+    EXPECT_EQ(qk->get_current_time(), start + 25 * quantum);
+    // SystemC was let through up to the last budget handed out
+    EXPECT_GE(sc_core::sc_time_stamp() + 2 * quantum, qk->get_current_time());
+}
+
+TEST(qkmultithread, concurrent_inc)
+{
+    qk->reset();
+    sc_core::sc_time start = qk->get_current_time();
+    std::vector<std::thread> threads;
+    for (int i = 0; i < 4; i++) {
+        threads.emplace_back([]() {
+            for (int j = 0; j < 1000; j++) {
+                qk->inc(sc_core::sc_time(1, sc_core::SC_NS));
+            }
+        });
+    }
+    for (auto& t : threads) {
+        t.join();
+    }
+    EXPECT_EQ(qk->get_current_time(), start + sc_core::sc_time(4000, sc_core::SC_NS));
+}
+
+TEST(qkmultithread, set_not_backwards)
+{
+    qk->reset();
+    sc_core::sc_time now = sc_core::sc_time_stamp();
+    qk->set(sc_core::sc_time(10, sc_core::SC_US));
+    EXPECT_EQ(qk->get_current_time(), now + sc_core::sc_time(10, sc_core::SC_US));
+    qk->set(sc_core::sc_time(5, sc_core::SC_US));
+    EXPECT_EQ(qk->get_current_time(), now + sc_core::sc_time(10, sc_core::SC_US));
+    qk->inc(sc_core::sc_time(1, sc_core::SC_US));
+    EXPECT_EQ(qk->get_current_time(), now + sc_core::sc_time(11, sc_core::SC_US));
+}
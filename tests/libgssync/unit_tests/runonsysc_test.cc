@@ -0,0 +1,98 @@
+/*
+ * Copyright (c) 2024 Qualcomm Innovation Center, Inc. All Rights Reserved.
+ *
+ * SPDX-License-Identifier: BSD-3-Clause
+ */
+
+#include <gtest/gtest.h>
+#include <gmock/gmock.h>
+#include "runonsysc.h"
+
+#include <atomic>
+#include <thread>
+#include <vector>
+
+gs::runonsysc* sc = nullptr;
+
+// run the kernel until the producers are done and their jobs have been handled
+void run_until(std::atomic<bool>& done)
+{
+    while (!done || sc_core::sc_pending_activity()) {
+        sc_core::sc_start(sc_core::SC_ZERO_TIME);
+    }
+}
+
+int sc_main(int argc, char** argv)
+{
+    sc = new gs::runonsysc("run_on_sysc");
+    testing::InitGoogleTest(&argc, argv);
+    int status = RUN_ALL_TESTS();
+    return status;
+}
+
+TEST(runonsysc, on_sysc_thread)
+{
+    // called from the SystemC thread, the job runs straight away
+    bool ran = false;
+    EXPECT_TRUE(sc->run_on_sysc([&ran]() { ran = true; }));
+    EXPECT_TRUE(ran);
+}
+
+TEST(runonsysc, many_producers)
+{
+    constexpr int producers = 4;
+    constexpr int jobs = 1000;
+    std::vector<int> last(producers, -1);
+    bool in_order = true;
+    int ran = 0;
+    std::atomic<int> finished{ 0 };
+    std::atomic<bool> done{ false };
+
+    std::vector<std::thread> threads;
+    for (int p = 0; p < producers; p++) {
+        threads.emplace_back([&, p]() {
+            for (int i = 0; i < jobs; i++) {
+                auto job = [&, p, i]() {
+                    EXPECT_TRUE(sc->is_on_sysc());
+                    in_order = in_order && (last[p] + 1 == i);
+                    last[p] = i;
+                    ran++;
+                };
+                // mix jobs waited for and forked ones
+                if (i % 10 == 0) {
+                    EXPECT_TRUE(sc->run_on_sysc(job));
+                } else {
+                    sc->fork_on_systemc(job);
+                }
+            }
+            if (++finished == producers) {
+                done = true;
+            }
+        });
+    }
+    run_until(done);
+    for (auto& t : threads) {
+        t.join();
+    }
+
+    // each producer's jobs run once, in the order they were queued
+    EXPECT_TRUE(in_order);
+    EXPECT_EQ(ran, producers * jobs);
+}
+
+TEST(runonsysc, past_the_pool)
+{
+    // more jobs pending at once than the pool of slots holds, none is lost
+    constexpr int jobs = 70000;
+    int ran = 0;
+    std::thread t([&ran]() {
+        for (int i = 0; i < jobs; i++) {
+            sc->fork_on_systemc([&ran]() { ran++; });
+        }
+    });
+    t.join();
+
+    std::atomic<bool> done{ true };
+    run_until(done);
+    EXPECT_EQ(ran, jobs);
+}